@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+#include "fastcast_arena.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+// Some payload so the objects don't share their cache lines
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    double payload[6];
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<F>> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public E
+{
+    typedef fastcast::hierarchy<E, fastcast::children<G>> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public F
+{
+    typedef fastcast::hierarchy<F> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+using Arena = fastcast::slab_arena<A>;
+
+struct New
+{
+    template<typename T>
+    A * make() { return new T; }
+};
+
+struct InArena
+{
+    Arena & arena;
+
+    template<typename T>
+    A * make() { return arena.make<T>(); }
+};
+
+template<typename Maker>
+void fill(std::vector<A *> & v, const std::vector<int> & types, Maker maker)
+{
+    v.clear();
+    for (auto t : types)
+    {
+        switch (t)
+        {
+        case 0: v.push_back(maker.template make<C>()); break;
+        case 1: v.push_back(maker.template make<D>()); break;
+        case 2: v.push_back(maker.template make<F>()); break;
+        default: v.push_back(maker.template make<G>()); break;
+        }
+    }
+}
+
+template<typename T>
+unsigned long long fast_cast(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += Fcast::cast<T>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T>
+unsigned long long arena_cast(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += Arena::cast<T>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<int> types(N);
+        std::vector<A *> v1, v2;
+        unsigned long long mean1, mean2;
+        std::mt19937 gen(0);
+
+        for (auto & t : types)
+        {
+            t = gen() % 4;
+        }
+
+        std::cout << "new (random mix of C, D, F, G) and delete:" << std::endl;
+        mean1 = bench(L, [&]() {
+                fill(v1, types, New());
+                for (auto p : v1) delete p;
+                return v1.size();
+            });
+
+        std::cout << "slab_arena::make and slab_arena::destroy:" << std::endl;
+        Arena arena;
+        mean2 = bench(L, [&]() {
+                fill(v2, types, InArena{arena});
+                for (auto p : v2) arena.destroy(p);
+                return v2.size();
+            });
+
+        compare("slab_arena", mean1, mean2);
+
+        // The objects are visited in a random order
+        fill(v1, types, New());
+        fill(v2, types, InArena{arena});
+        std::shuffle(v1.begin(), v1.end(), gen);
+        std::shuffle(v2.begin(), v2.end(), gen);
+
+        std::cout << "Fcast::cast<E> (objects allocated with new):" << std::endl;
+        mean1 = bench(L, [&]() { return fast_cast<E>(v1); });
+
+        std::cout << "slab_arena::cast<E>:" << std::endl;
+        mean2 = bench(L, [&]() { return arena_cast<E>(v2); });
+
+        compare("slab_arena::cast", mean1, mean2);
+
+        for (auto p : v1)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
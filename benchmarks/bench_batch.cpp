@@ -0,0 +1,164 @@
+#include <cstdlib>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<F>> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public E
+{
+    typedef fastcast::hierarchy<E, fastcast::children<G>> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public F
+{
+    typedef fastcast::hierarchy<F> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+// The scalar loop used in bench.cpp, keeping the casted pointers
+template<typename T>
+unsigned long long scalar_filter(const std::vector<A *> & v, std::vector<T *> & out)
+{
+    std::size_t n = 0;
+    for (auto p : v)
+    {
+        if (T * t = Fcast::cast<T>(p))
+        {
+            out[n++] = t;
+        }
+    }
+
+    return n;
+}
+
+template<typename T>
+unsigned long long batch_filter(const std::vector<A *> & v, std::vector<T *> & out)
+{
+    return Fcast::filter<T>(v.data(), v.size(), out.data());
+}
+
+template<typename T>
+unsigned long long scalar_count(const std::vector<A *> & v)
+{
+    unsigned long long n = 0;
+    for (auto p : v)
+    {
+        n += Fcast::instanceof<T>(p);
+    }
+
+    return n;
+}
+
+template<typename T>
+unsigned long long batch_count(const std::vector<A *> & v, std::vector<uint64_t> & mask)
+{
+    return Fcast::instanceof_n<T>(v.data(), v.size(), mask.data());
+}
+
+template<typename T>
+void run(const char * name, unsigned int L, const std::vector<A *> & v)
+{
+    std::vector<T *> out(v.size());
+    std::vector<uint64_t> mask((v.size() + 63) / 64);
+    unsigned long long mean1, mean2;
+
+    std::cout << "loop of Fcast::cast<" << name << ">:" << std::endl;
+    mean1 = bench(L, [&]() { return scalar_filter<T>(v, out); });
+
+    std::cout << "Fcast::filter<" << name << ">:" << std::endl;
+    mean2 = bench(L, [&]() { return batch_filter<T>(v, out); });
+
+    compare("filter", mean1, mean2);
+
+    std::cout << "loop of Fcast::instanceof<" << name << ">:" << std::endl;
+    mean1 = bench(L, [&]() { return scalar_count<T>(v); });
+
+    std::cout << "Fcast::instanceof_n<" << name << ">:" << std::endl;
+    mean2 = bench(L, [&]() { return batch_count<T>(v, mask); });
+
+    compare("instanceof_n", mean1, mean2);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v;
+
+        // A random mix of the concrete types, so the outcome of each test is unpredictable
+        std::srand(0);
+        v.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            switch (std::rand() % 4)
+            {
+            case 0: v.push_back(new C); break;
+            case 1: v.push_back(new D); break;
+            case 2: v.push_back(new F); break;
+            default: v.push_back(new G); break;
+            }
+        }
+
+        run<G>("G", L, v);
+        run<E>("E", L, v);
+        run<B>("B", L, v);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Build-time benchmark: generate a hierarchy of N classes (each class has Fanout children in breadth-first order)
+// where each constructor calls set_id and a function tests instanceof for each class, then compile it
+// and report the compile time and the peak memory of the compiler.
+
+std::string generate(unsigned int N, unsigned int Fanout)
+{
+    std::ostringstream out;
+    out << "#include \"fastcast.hxx\"\n\n";
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        out << "struct C" << i << ";\n";
+    }
+    out << "\nusing Fcast = fastcast::fcast<C0, uint64_t>;\n\n";
+
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        const unsigned int parent = i ? (i - 1) / Fanout : 0;
+        out << "struct C" << i << " : public " << (i ? "C" + std::to_string(parent) : std::string("Fcast")) << "\n{\n";
+        out << "    typedef fastcast::hierarchy<" << (i ? "C" + std::to_string(parent) : std::string("fastcast::root"));
+        if (Fanout * i + 1 < N)
+        {
+            out << ", fastcast::children<";
+            for (unsigned int j = Fanout * i + 1; j <= Fanout * i + Fanout && j < N; ++j)
+            {
+                out << (j == Fanout * i + 1 ? "" : ", ") << "C" << j;
+            }
+            out << ">";
+        }
+        out << "> fcast_hierarchy;\n";
+        out << "    C" << i << "() { Fcast::set_id<C" << i << ">(); }\n";
+        if (!i)
+        {
+            out << "    virtual ~C0() { }\n";
+        }
+        out << "};\n\n";
+    }
+
+    out << "unsigned int test(C0 * p)\n{\n    unsigned int n = 0;\n";
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        out << "    n += Fcast::instanceof<C" << i << ">(p);\n";
+    }
+    out << "    return n;\n}\n";
+
+    return out.str();
+}
+
+// Run the command and return its exit status, the elapsed time (in seconds) and the peak memory (in kB)
+// The command is run in a child process so the peak memory of each compilation is measured separately.
+int run(const std::vector<std::string> & args, double & seconds, long & kb)
+{
+    int fds[2];
+    if (pipe(fds))
+    {
+        return -1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        const pid_t compiler = fork();
+        if (compiler == 0)
+        {
+            std::vector<char *> argv;
+            for (const auto & a : args)
+            {
+                argv.push_back(const_cast<char *>(a.c_str()));
+            }
+            argv.push_back(nullptr);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status = -1;
+        waitpid(compiler, &status, 0);
+        struct rusage usage;
+        getrusage(RUSAGE_CHILDREN, &usage);
+        const long maxrss = usage.ru_maxrss;
+        if (write(fds[1], &maxrss, sizeof(maxrss)) != sizeof(maxrss))
+        {
+            _exit(127);
+        }
+        _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 127);
+    }
+
+    close(fds[1]);
+    kb = 0;
+    if (read(fds[0], &kb, sizeof(kb)) != sizeof(kb))
+    {
+        kb = -1;
+    }
+    close(fds[0]);
+
+    int status = -1;
+    waitpid(pid, &status, 0);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// bench_build [path to fastcast.hxx directory] [compilers...]
+// For example: ./bench_build .. g++ clang++
+int main(int argc, char ** argv)
+{
+    const std::string include = argc >= 2 ? argv[1] : "..";
+    std::vector<std::string> compilers;
+    for (int i = 2; i < argc; ++i)
+    {
+        compilers.push_back(argv[i]);
+    }
+    if (compilers.empty())
+    {
+        compilers = { "g++", "clang++" };
+    }
+
+    const unsigned int sizes[] = { 50, 100, 200, 400, 800 };
+    const unsigned int fanouts[] = { 8, 64 };
+
+    std::cout << "compiler,classes,fanout,seconds,peak_kb" << std::endl;
+    for (auto fanout : fanouts)
+    for (auto N : sizes)
+    {
+        const std::string source = "bench_build_" + std::to_string(N) + "_" + std::to_string(fanout) + ".cpp";
+        {
+            std::ofstream out(source);
+            out << generate(N, fanout);
+        }
+
+        for (const auto & cxx : compilers)
+        {
+            double seconds;
+            long kb;
+            const int status = run({ cxx, "-std=c++11", "-c", "-o", "/dev/null", "-I" + include, source }, seconds, kb);
+            if (status == 127)
+            {
+                std::cerr << cxx << " is not available" << std::endl;
+                continue;
+            }
+
+            std::cout << cxx << ',' << N << ',' << fanout << ',';
+            if (status)
+            {
+                std::cout << "failed," << std::endl;
+            }
+            else
+            {
+                std::cout << seconds << ',' << kb << std::endl;
+            }
+        }
+
+        std::remove(source.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef __BENCH_COMMON_HXX__
+#define __BENCH_COMMON_HXX__
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cmath>
+
+// Run L times func and print the mean and the standard deviation of the elapsed times
+// The returned value of func is accumulated to avoid the call to be optimized out
+template<typename F>
+unsigned long long bench(unsigned int L, F func)
+{
+    std::vector<unsigned long long> times;
+    unsigned long long sink = 0;
+    for (unsigned int i = 0; i < L; i++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sink += func();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    }
+
+    unsigned long long m = 0;
+    for (auto i : times)
+    {
+        m += i;
+    }
+
+    m /= L;
+    double e = 0;
+    for (auto i : times)
+    {
+        e += ((double)m - i) * ((double)m - i);
+    }
+    e /= L;
+    e = sqrt(e);
+
+    std::cout << L << " loops: " << "mean=" << m << "(microsecs) and sigma=" << e << " (" << (sink & 1) << ")" << std::endl;
+
+    return m ? m : 1;
+}
+
+// Print the ratio between two means
+inline void compare(const char * name, unsigned long long ref, unsigned long long mean)
+{
+    std::cout << name << " is " << (((double)ref) / mean) << " times faster." << std::endl << std::endl;
+}
+
+#endif // __BENCH_COMMON_HXX__
@@ -0,0 +1,74 @@
+#include <cstdlib>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+// Two chains K<Each, 0>--K<Each, 1>--...--K<Each, Depth - 1>:
+// with Each == true every constructor sets the id, with Each == false it is set once by fastcast::construct
+constexpr unsigned int Depth = 8;
+
+template<bool Each, unsigned int N>
+struct K;
+
+// We use volatile here to force to store the _fcast_id property
+template<bool Each>
+using Fcast = fastcast::fcast<K<Each, 0>, volatile uint64_t>;
+
+template<bool Each, unsigned int N>
+using Next = typename std::conditional<N + 1 < Depth, fastcast::children<K<Each, N + 1>>, void>::type;
+
+template<bool Each>
+struct K<Each, 0> : public Fcast<Each>
+{
+    typedef fastcast::hierarchy<fastcast::root, Next<Each, 0>> fcast_hierarchy;
+
+    K() { if (Each) this->template set_id<K>(); }
+};
+
+template<bool Each, unsigned int N>
+struct K : public K<Each, N - 1>
+{
+    typedef fastcast::hierarchy<K<Each, N - 1>, Next<Each, N>> fcast_hierarchy;
+
+    K() { if (Each) this->template set_id<K>(); }
+};
+
+template<bool Each>
+using Leaf = K<Each, Depth - 1>;
+
+static_assert(sizeof(Leaf<true>) == sizeof(Leaf<false>), "The two chains must have the same layout");
+
+template<bool Each>
+unsigned long long build(Leaf<Each> * buffer, std::size_t N)
+{
+    unsigned long long s = 0;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        Leaf<Each> * p = Each ? new (buffer + i) Leaf<Each>() : fastcast::construct<Leaf<Each>>(buffer + i);
+        s += Fcast<Each>::template same<Leaf<Each>>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<Leaf<true>> v1(N);
+        std::vector<Leaf<false>> v2(N);
+        unsigned long long mean1, mean2;
+
+        std::cout << "construction with one set_id by constructor (" << Depth << " levels):" << std::endl;
+        mean1 = bench(L, [&]() { return build<true>(v1.data(), N); });
+
+        std::cout << "fastcast::construct (one store):" << std::endl;
+        mean2 = bench(L, [&]() { return build<false>(v2.data(), N); });
+
+        compare("fastcast::construct", mean1, mean2);
+    }
+
+    return 0;
+}
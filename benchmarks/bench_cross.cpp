@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <random>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+// The hierarchy of test/test_cross.cpp: G and H derive from the two roots A and D
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using FcastA = fastcast::fcast<A, uint64_t>;
+using FcastD = fastcast::fcast<D, uint64_t>;
+
+struct A : public FcastA
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { FcastA::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    B() { FcastA::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+    C() { FcastA::set_id<C>(); }
+};
+
+struct D : public FcastD
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<E, F>> fcast_hierarchy;
+    D() { FcastD::set_id<D>(); }
+    virtual ~D() { }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<G>> fcast_hierarchy;
+    E() { FcastD::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    F() { FcastD::set_id<F>(); }
+};
+
+struct G : public C, public E
+{
+    typedef fastcast::hierarchy<fastcast::parents<C, E>, fastcast::children<H>> fcast_hierarchy;
+    G() { FcastA::set_id<G>(); FcastD::set_id<G>(); }
+};
+
+struct H : public G
+{
+    typedef fastcast::hierarchy<G> fcast_hierarchy;
+    H() { FcastA::set_id<H>(); FcastD::set_id<H>(); }
+};
+
+template<typename T>
+unsigned long long dynamic(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += dynamic_cast<T *>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T>
+unsigned long long fast(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += fastcast::cross_cast<T>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v(N);
+        unsigned long long mean1, mean2;
+        std::mt19937 gen(0);
+
+        for (auto & p : v)
+        {
+            switch (gen() % 4)
+            {
+            case 0: p = new B; break;
+            case 1: p = new C; break;
+            case 2: p = new G; break;
+            default: p = new H; break;
+            }
+        }
+
+        std::cout << "dynamic_cast<D*>(A*) (random mix of B, C, G, H):" << std::endl;
+        mean1 = bench(L, [&]() { return dynamic<D>(v); });
+
+        std::cout << "fastcast::cross_cast<D>(A*):" << std::endl;
+        mean2 = bench(L, [&]() { return fast<D>(v); });
+
+        compare("fastcast::cross_cast", mean1, mean2);
+
+        std::cout << "dynamic_cast<E*>(A*):" << std::endl;
+        mean1 = bench(L, [&]() { return dynamic<E>(v); });
+
+        std::cout << "fastcast::cross_cast<E>(A*):" << std::endl;
+        mean2 = bench(L, [&]() { return fast<E>(v); });
+
+        compare("fastcast::cross_cast", mean1, mean2);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "fastcast_factory.hxx"
+#include "bench_common.hxx"
+
+// 16 message classes with sparse tags (as the hashes of their names would be)
+struct A;
+
+template<int I>
+struct Message;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<Message<0>, Message<1>, Message<2>, Message<3>, Message<4>, Message<5>, Message<6>, Message<7>,
+                                                                   Message<8>, Message<9>, Message<10>, Message<11>, Message<12>, Message<13>, Message<14>, Message<15>>> fcast_hierarchy;
+
+    virtual ~A() { }
+    virtual int value() const = 0;
+};
+
+template<int I>
+struct Message : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    typedef fastcast::tag<Message, 0x9E3779B1u * (I + 1)> fcast_tag;
+
+    int v;
+    Message() : v(I) { }
+    int value() const { return v; }
+};
+
+using Factory = fastcast::factory<A>;
+
+typedef A * (*creator)(void *);
+
+template<int I>
+A * create(void * where)
+{
+    return new (where) Message<I>();
+}
+
+template<int... I>
+void registry(std::unordered_map<std::string, creator> & map, std::vector<std::string> & names, std::vector<fastcast::fcast_tag_t> & tags)
+{
+    const creator creators[] = { &create<I>... };
+    const fastcast::fcast_tag_t t[] = { Factory::tag<Message<I>>()... };
+    for (std::size_t i = 0; i < sizeof...(I); ++i)
+    {
+        names.push_back("message." + std::to_string(i));
+        map.emplace(names.back(), creators[i]);
+        tags.push_back(t[i]);
+    }
+}
+
+// Build each message in the same storage and destroy it
+unsigned long long decode_map(const std::vector<std::string> & stream, const std::unordered_map<std::string, creator> & map, void * storage)
+{
+    unsigned long long s = 0;
+    for (const auto & name : stream)
+    {
+        A * a = map.find(name)->second(storage);
+        s += a->value();
+        a->~A();
+    }
+
+    return s;
+}
+
+unsigned long long decode_factory(const std::vector<fastcast::fcast_tag_t> & stream, void * storage)
+{
+    unsigned long long s = 0;
+    for (auto tag : stream)
+    {
+        A * a = Factory::construct(storage, tag);
+        s += a->value();
+        a->~A();
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        unsigned long long mean1, mean2;
+
+        std::unordered_map<std::string, creator> map;
+        std::vector<std::string> names;
+        std::vector<fastcast::fcast_tag_t> tags;
+        registry<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15>(map, names, tags);
+
+        // the same random stream of messages with names and with tags
+        std::vector<std::string> by_name(N);
+        std::vector<fastcast::fcast_tag_t> by_tag(N);
+        std::mt19937 gen(0);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            const std::size_t k = gen() % names.size();
+            by_name[i] = names[k];
+            by_tag[i] = tags[k];
+        }
+
+        alignas(Factory::max_align) char storage[Factory::max_size];
+
+        std::cout << "std::unordered_map<std::string, creator>:" << std::endl;
+        mean1 = bench(L, [&]() { return decode_map(by_name, map, storage); });
+
+        std::cout << "fastcast::factory::construct:" << std::endl;
+        mean2 = bench(L, [&]() { return decode_factory(by_tag, storage); });
+
+        compare("fastcast::factory", mean1, mean2);
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "fastcast_hybrid.hxx"
+#include "bench_common.hxx"
+
+// A registered hierarchy (A, B, C, D) and classes which are not registered (Named is a third-party interface)
+struct A;
+struct B;
+struct C;
+struct D;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct Named
+{
+    virtual ~Named() { }
+};
+
+struct X : public B, public Named { };
+struct Y : public D { };
+struct Z : public C, public Named { };
+struct W : public D, public Named { };
+
+template<typename T, bool Hybrid>
+unsigned long long run(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += (Hybrid ? fastcast::hybrid_cast<T>(p) : dynamic_cast<T *>(p)) ? 1 : 0;
+    }
+
+    return s;
+}
+
+// Run func(t) in T threads and sum the results
+template<typename F>
+unsigned long long parallel(unsigned int T, F func)
+{
+    std::vector<unsigned long long> sums(T);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < T; ++t)
+    {
+        threads.emplace_back([&, t]() { sums[t] = func(t); });
+    }
+
+    unsigned long long s = 0;
+    for (unsigned int t = 0; t < T; ++t)
+    {
+        threads[t].join();
+        s += sums[t];
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 4)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        unsigned int T = std::atol(argv[3]);
+        std::vector<A *> v(N);
+        unsigned long long mean1, mean2;
+        std::mt19937 gen(0);
+
+        // half of the objects are instances of classes which are not registered
+        for (auto & p : v)
+        {
+            switch (gen() % 8)
+            {
+            case 0: p = new A; break;
+            case 1: p = new B; break;
+            case 2: p = new C; break;
+            case 3: p = new D; break;
+            case 4: p = new X; break;
+            case 5: p = new Y; break;
+            case 6: p = new Z; break;
+            default: p = new W; break;
+            }
+        }
+
+        std::cout << T << " threads, dynamic_cast<D*>(A*):" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<D, false>(v); }); });
+
+        std::cout << T << " threads, fastcast::hybrid_cast<D>(A*) (with the ids):" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<D, true>(v); }); });
+
+        compare("fastcast::hybrid_cast", mean1, mean2);
+
+        std::cout << T << " threads, dynamic_cast<Named*>(A*):" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<Named, false>(v); }); });
+
+        std::cout << T << " threads, fastcast::hybrid_cast<Named>(A*) (with the cache):" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<Named, true>(v); }); });
+
+        compare("fastcast::hybrid_cast", mean1, mean2);
+
+        std::cout << T << " threads, dynamic_cast<X*>(A*):" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<X, false>(v); }); });
+
+        std::cout << T << " threads, fastcast::hybrid_cast<X>(A*) (with the cache):" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return run<X, true>(v); }); });
+
+        compare("fastcast::hybrid_cast", mean1, mean2);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <cstdlib>
+
+#include "fastcast_index.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+// Visit the instances of T in testing each object
+template<typename T>
+unsigned long long scan(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        if (T * t = Fcast::cast<T>(p))
+        {
+            s += reinterpret_cast<std::uintptr_t>(t) >> 4;
+        }
+    }
+
+    return s;
+}
+
+// Visit the instances of T in the index
+template<typename T>
+unsigned long long visit(const fastcast::type_sorted_index<A> & index)
+{
+    unsigned long long s = 0;
+    index.for_each<T>([&](T & t) { s += reinterpret_cast<std::uintptr_t>(&t) >> 4; });
+
+    return s;
+}
+
+// Visit the instances of T in the array sorted by type
+template<typename T>
+unsigned long long range(std::vector<A *> & sorted)
+{
+    unsigned long long s = 0;
+    const std::pair<A **, A **> r = fastcast::type_range<T>(sorted.data(), sorted.data() + sorted.size());
+    for (A ** p = r.first; p != r.second; ++p)
+    {
+        s += reinterpret_cast<std::uintptr_t>(static_cast<T *>(*p)) >> 4;
+    }
+
+    return s;
+}
+
+template<typename T>
+void run(const char * name, unsigned int L, std::vector<A *> & v, const fastcast::type_sorted_index<A> & index, std::vector<A *> & sorted)
+{
+    unsigned long long mean1, mean2;
+
+    std::cout << "Fcast::cast<" << name << "> on each object:" << std::endl;
+    mean1 = bench(L, [&]() { return scan<T>(v); });
+
+    std::cout << "fastcast::type_sorted_index::for_each<" << name << ">:" << std::endl;
+    mean2 = bench(L, [&]() { return visit<T>(index); });
+    compare("fastcast::type_sorted_index", mean1, mean2);
+
+    std::cout << "fastcast::type_range<" << name << "> on the sorted array:" << std::endl;
+    mean2 = bench(L, [&]() { return range<T>(sorted); });
+    compare("fastcast::type_range", mean1, mean2);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v;
+        fastcast::type_sorted_index<A> index;
+
+        std::srand(0);
+        v.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            switch (std::rand() % 7)
+            {
+            case 0: v.push_back(new A); break;
+            case 1: v.push_back(new B); break;
+            case 2: v.push_back(new C); break;
+            case 3: v.push_back(new D); break;
+            case 4: v.push_back(new E); break;
+            case 5: v.push_back(new F); break;
+            default: v.push_back(new G); break;
+            }
+            index.insert(v.back());
+        }
+
+        std::vector<A *> sorted(v);
+        fastcast::sort_by_type(sorted.data(), sorted.data() + sorted.size());
+
+        run<C>("C", L, v, index, sorted);
+        run<D>("D", L, v, index, sorted);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <cstdlib>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+unsigned long long fast_cast_chain(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        if (Fcast::cast<G>(p)) s += 7;
+        else if (Fcast::cast<F>(p)) s += 6;
+        else if (Fcast::cast<E>(p)) s += 5;
+        else if (Fcast::cast<D>(p)) s += 4;
+        else if (Fcast::cast<C>(p)) s += 3;
+        else if (Fcast::cast<B>(p)) s += 2;
+        else s += 1;
+    }
+
+    return s;
+}
+
+unsigned long long dynamic_cast_chain(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        if (dynamic_cast<G *>(p)) s += 7;
+        else if (dynamic_cast<F *>(p)) s += 6;
+        else if (dynamic_cast<E *>(p)) s += 5;
+        else if (dynamic_cast<D *>(p)) s += 4;
+        else if (dynamic_cast<C *>(p)) s += 3;
+        else if (dynamic_cast<B *>(p)) s += 2;
+        else s += 1;
+    }
+
+    return s;
+}
+
+unsigned long long match(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += fastcast::match<A>(p,
+                                [](G &) { return 7; },
+                                [](F &) { return 6; },
+                                [](E &) { return 5; },
+                                [](D &) { return 4; },
+                                [](C &) { return 3; },
+                                [](B &) { return 2; },
+                                [](A &) { return 1; });
+    }
+
+    return s;
+}
+
+unsigned long long matcher(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    auto m = fastcast::make_matcher<A>([](G &) { return 7; },
+                                       [](F &) { return 6; },
+                                       [](E &) { return 5; },
+                                       [](D &) { return 4; },
+                                       [](C &) { return 3; },
+                                       [](B &) { return 2; },
+                                       [](A &) { return 1; });
+    for (auto p : v)
+    {
+        s += m(p);
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v;
+        unsigned long long mean1, mean2, mean3, mean4;
+
+        // A random mix of all the types, so the branches are unpredictable
+        std::srand(0);
+        v.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            switch (std::rand() % 7)
+            {
+            case 0: v.push_back(new A); break;
+            case 1: v.push_back(new B); break;
+            case 2: v.push_back(new C); break;
+            case 3: v.push_back(new D); break;
+            case 4: v.push_back(new E); break;
+            case 5: v.push_back(new F); break;
+            default: v.push_back(new G); break;
+            }
+        }
+
+        std::cout << "chain of dynamic_cast:" << std::endl;
+        mean1 = bench(L, [&]() { return dynamic_cast_chain(v); });
+
+        std::cout << "chain of Fcast::cast:" << std::endl;
+        mean2 = bench(L, [&]() { return fast_cast_chain(v); });
+
+        std::cout << "fastcast::match:" << std::endl;
+        mean3 = bench(L, [&]() { return match(v); });
+
+        std::cout << "fastcast::matcher:" << std::endl;
+        mean4 = bench(L, [&]() { return matcher(v); });
+
+        compare("match (vs dynamic_cast)", mean1, mean3);
+        compare("match (vs Fcast::cast)", mean2, mean3);
+        compare("matcher (vs Fcast::cast)", mean2, mean4);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <cstdlib>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+// The most specific rule among (G, G), (G, D), (D, G), (D, D), (B, C), (C, B) and (A, A)
+int rule_chain(A * p, A * q)
+{
+    if (Fcast::cast<G>(p))
+    {
+        if (Fcast::cast<G>(q)) return 1;
+        if (Fcast::cast<D>(q)) return 2;
+    }
+    if (Fcast::cast<D>(p))
+    {
+        if (Fcast::cast<G>(q)) return 3;
+        if (Fcast::cast<D>(q)) return 4;
+    }
+    if (Fcast::cast<B>(p) && Fcast::cast<C>(q)) return 5;
+    if (Fcast::cast<C>(p) && Fcast::cast<B>(q)) return 6;
+    return 7;
+}
+
+unsigned long long cast_chain(const std::vector<A *> & v)
+{
+    unsigned long long s = 0;
+    for (std::size_t i = 0; i + 1 < v.size(); i += 2)
+    {
+        s += rule_chain(v[i], v[i + 1]);
+    }
+
+    return s;
+}
+
+template<typename M>
+unsigned long long method(const std::vector<A *> & v, M & m)
+{
+    unsigned long long s = 0;
+    for (std::size_t i = 0; i + 1 < v.size(); i += 2)
+    {
+        s += m(*v[i], *v[i + 1]);
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v;
+        unsigned long long mean1, mean2;
+
+        // Random pairs of all the types, so the branches are unpredictable
+        std::srand(0);
+        v.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            switch (std::rand() % 7)
+            {
+            case 0: v.push_back(new A); break;
+            case 1: v.push_back(new B); break;
+            case 2: v.push_back(new C); break;
+            case 3: v.push_back(new D); break;
+            case 4: v.push_back(new E); break;
+            case 5: v.push_back(new F); break;
+            default: v.push_back(new G); break;
+            }
+        }
+
+        auto m = fastcast::make_multimethod<int(A &, A &)>([](G &, G &) { return 1; },
+                                                          [](G &, D &) { return 2; },
+                                                          [](D &, G &) { return 3; },
+                                                          [](D &, D &) { return 4; },
+                                                          [](B &, C &) { return 5; },
+                                                          [](C &, B &) { return 6; },
+                                                          [](A &, A &) { return 7; });
+
+        std::cout << "nested chains of Fcast::cast:" << std::endl;
+        mean1 = bench(L, [&]() { return cast_chain(v); });
+
+        std::cout << "fastcast::multimethod:" << std::endl;
+        mean2 = bench(L, [&]() { return method(v, m); });
+
+        compare("fastcast::multimethod", mean1, mean2);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "fastcast_parallel.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C, D>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<E, F>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<H>> fcast_hierarchy;
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public C
+{
+    typedef fastcast::hierarchy<C> fcast_hierarchy;
+    G() { Fcast::set_id<G>(); }
+};
+
+struct H : public F
+{
+    typedef fastcast::hierarchy<F> fcast_hierarchy;
+    H() { Fcast::set_id<H>(); }
+};
+
+// The single-threaded pass: the worklist of each class is filled with a chain of casts
+struct worklists
+{
+    std::vector<A *> a, b, c, d, e, f, g, h;
+
+    unsigned long long split(const std::vector<A *> & v)
+        {
+            a.clear(); b.clear(); c.clear(); d.clear(); e.clear(); f.clear(); g.clear(); h.clear();
+            for (auto p : v)
+            {
+                if (H * x = Fcast::cast<H>(p)) h.push_back(x);
+                else if (F * x = Fcast::cast<F>(p)) f.push_back(x);
+                else if (E * x = Fcast::cast<E>(p)) e.push_back(x);
+                else if (G * x = Fcast::cast<G>(p)) g.push_back(x);
+                else if (B * x = Fcast::cast<B>(p)) b.push_back(x);
+                else if (C * x = Fcast::cast<C>(p)) c.push_back(x);
+                else if (D * x = Fcast::cast<D>(p)) d.push_back(x);
+                else a.push_back(p);
+            }
+
+            return h.size() + b.size();
+        }
+};
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 4)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        unsigned int T = std::atol(argv[3]);
+        std::vector<A *> v(N);
+        std::mt19937 gen(0);
+
+        for (auto & p : v)
+        {
+            switch (gen() % 8)
+            {
+            case 0: p = new A; break;
+            case 1: p = new B; break;
+            case 2: p = new C; break;
+            case 3: p = new D; break;
+            case 4: p = new E; break;
+            case 5: p = new F; break;
+            case 6: p = new G; break;
+            default: p = new H; break;
+            }
+        }
+        // the objects are not visited in the order of their allocation
+        std::shuffle(v.begin(), v.end(), gen);
+
+        worklists lists;
+        std::cout << "Chain of Fcast::cast in one thread:" << std::endl;
+        const unsigned long long mean1 = bench(L, [&]() { return lists.split(v); });
+
+        fastcast::type_buckets<A> buckets;
+        for (unsigned int t = 1; t <= T; t *= 2)
+        {
+            fastcast::work_stealing_pool pool(t);
+            std::cout << "fastcast::bucket_by_type with " << t << " workers:" << std::endl;
+            const unsigned long long mean2 = bench(L, [&]()
+                                                   {
+                                                       fastcast::bucket_by_type(v.data(), v.data() + v.size(), pool, buckets);
+                                                       return buckets.size();
+                                                   });
+            compare(("fastcast::bucket_by_type with " + std::to_string(t) + " workers").c_str(), mean1, mean2);
+        }
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
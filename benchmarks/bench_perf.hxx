@@ -0,0 +1,122 @@
+#ifndef __BENCH_PERF_HXX__
+#define __BENCH_PERF_HXX__
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+// Hardware counters (cycles, instructions and branch misses) read with perf_event_open
+// When they are not available (not Linux, perf_event_paranoid, virtual machine...), valid() returns false.
+class perf_counters
+{
+public:
+
+    enum { cycles, instructions, branch_misses, count };
+
+    perf_counters() : leader(-1)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                fds[i] = -1;
+                values[i] = 0;
+            }
+#if defined(__linux__)
+            const uint64_t configs[count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES };
+            for (int i = 0; i < count; ++i)
+            {
+                struct perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[i];
+                attr.disabled = i == 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                fds[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+                if (fds[i] < 0)
+                {
+                    close_all();
+                    return;
+                }
+                if (i == 0)
+                {
+                    leader = fds[0];
+                }
+            }
+#endif
+        }
+
+    ~perf_counters()
+        {
+            close_all();
+        }
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters & operator=(const perf_counters &) = delete;
+
+    bool valid() const
+        {
+            return leader >= 0;
+        }
+
+    void start()
+        {
+#if defined(__linux__)
+            if (valid())
+            {
+                ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+
+    void stop()
+        {
+#if defined(__linux__)
+            if (valid())
+            {
+                ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+                for (int i = 0; i < count; ++i)
+                {
+                    uint64_t v = 0;
+                    values[i] = read(fds[i], &v, sizeof(v)) == sizeof(v) ? v : 0;
+                }
+            }
+#endif
+        }
+
+    // The value of the counter i during the last start/stop
+    uint64_t operator[](int i) const
+        {
+            return values[i];
+        }
+
+private:
+
+    int leader;
+    int fds[count];
+    uint64_t values[count];
+
+    void close_all()
+        {
+#if defined(__linux__)
+            for (int i = count - 1; i >= 0; --i)
+            {
+                if (fds[i] >= 0)
+                {
+                    close(fds[i]);
+                    fds[i] = -1;
+                }
+            }
+#endif
+            leader = -1;
+        }
+};
+
+#endif // __BENCH_PERF_HXX__
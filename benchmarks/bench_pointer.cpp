@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "fastcast_pointer.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint64_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+
+// Cast N times the same shared pointer (with std::dynamic_pointer_cast when Dynamic is true)
+template<typename T, bool Dynamic>
+unsigned long long cast_shared(const std::shared_ptr<A> & p, std::size_t N)
+{
+    unsigned long long s = 0;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        s += (Dynamic ? std::dynamic_pointer_cast<T>(p) : fastcast::cast<T>(p)) != nullptr;
+    }
+
+    return s;
+}
+
+// Cast N times the pointers of v: each one is moved to the casted pointer then moved back
+template<typename T, bool Dynamic>
+unsigned long long cast_moved(std::vector<std::shared_ptr<A>> & v, std::size_t N)
+{
+    unsigned long long s = 0;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        std::shared_ptr<A> & p = v[i % v.size()];
+        std::shared_ptr<T> t = Dynamic ? std::dynamic_pointer_cast<T>(std::move(p)) : fastcast::cast<T>(std::move(p));
+        s += t != nullptr;
+        p = std::move(t);
+    }
+
+    return s;
+}
+
+// Run func(t) in T threads and sum the results
+template<typename F>
+unsigned long long parallel(unsigned int T, F func)
+{
+    std::vector<unsigned long long> sums(T);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < T; ++t)
+    {
+        threads.emplace_back([&, t]() { sums[t] = func(t); });
+    }
+
+    unsigned long long s = 0;
+    for (unsigned int t = 0; t < T; ++t)
+    {
+        threads[t].join();
+        s += sums[t];
+    }
+
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 4)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        unsigned int T = std::atol(argv[3]);
+        unsigned long long mean1, mean2;
+
+        // all the threads cast the same pointer: the reference count is contended
+        const std::shared_ptr<A> shared = std::make_shared<G>();
+
+        std::cout << T << " threads, std::dynamic_pointer_cast<B> of a shared G:" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return cast_shared<B, true>(shared, N); }); });
+
+        std::cout << T << " threads, fastcast::cast<B> of a shared G:" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return cast_shared<B, false>(shared, N); }); });
+
+        compare("fastcast::cast", mean1, mean2);
+
+        std::cout << T << " threads, std::dynamic_pointer_cast<C> of a shared G (fails):" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return cast_shared<C, true>(shared, N); }); });
+
+        std::cout << T << " threads, fastcast::cast<C> of a shared G (fails):" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int) { return cast_shared<C, false>(shared, N); }); });
+
+        compare("fastcast::cast", mean1, mean2);
+
+        // each thread moves its own pointers
+        std::vector<std::vector<std::shared_ptr<A>>> owned(T);
+        for (auto & v : owned)
+        {
+            for (std::size_t i = 0; i < 1024; ++i)
+            {
+                v.push_back(std::make_shared<G>());
+            }
+        }
+
+        std::cout << T << " threads, std::dynamic_pointer_cast<B> of moved pointers:" << std::endl;
+        mean1 = bench(L, [&]() { return parallel(T, [&](unsigned int t) { return cast_moved<B, true>(owned[t], N); }); });
+
+        std::cout << T << " threads, fastcast::cast<B> of moved pointers:" << std::endl;
+        mean2 = bench(L, [&]() { return parallel(T, [&](unsigned int t) { return cast_moved<B, false>(owned[t], N); }); });
+
+        compare("fastcast::cast", mean1, mean2);
+    }
+
+    return 0;
+}
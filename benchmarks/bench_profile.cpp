@@ -0,0 +1,36 @@
+#include <cstdlib>
+#include <iostream>
+
+// This translation unit is profiled (add -DFASTCAST_PROFILE_CYCLES to count the cycles too),
+// bench_profile_off.cpp times the same loop without profiling
+#ifndef FASTCAST_PROFILE
+# define FASTCAST_PROFILE
+#endif
+
+#define BENCH_PROFILE_NS profiled
+#include "bench_profile.hxx"
+
+unsigned long long bench_unprofiled_cast(unsigned int L, std::size_t N);
+
+// The ratio between the two loops is the cost of the profiling
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        unsigned long long mean1, mean2;
+
+        std::cout << "Fcast::cast<B> without FASTCAST_PROFILE:" << std::endl;
+        mean1 = bench_unprofiled_cast(L, N);
+
+        std::cout << "Fcast::cast<B> with FASTCAST_PROFILE:" << std::endl;
+        mean2 = profiled::bench_cast(L, N);
+
+        compare("The profiled Fcast::cast", mean1, mean2);
+
+        fastcast::profile::write_text(std::cout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef __BENCH_PROFILE_HXX__
+#define __BENCH_PROFILE_HXX__
+
+#include <cstdlib>
+#include <vector>
+
+#include "fastcast.hxx"
+#include "bench_common.hxx"
+
+// The hierarchy and the loop timed by bench_profile.cpp: this file is included by two translation units,
+// one with FASTCAST_PROFILE and one without, each in its own namespace (BENCH_PROFILE_NS) so the casts are
+// different instantiations
+namespace BENCH_PROFILE_NS
+{
+    struct A;
+    struct B;
+    struct C;
+    struct D;
+    struct E;
+
+    using Fcast = fastcast::fcast<A, uint64_t>;
+
+    struct A : public Fcast
+    {
+        typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+        A() { Fcast::set_id<A>(); }
+
+        virtual ~A() { }
+    };
+
+    struct B : public A
+    {
+        typedef fastcast::hierarchy<A, fastcast::children<D, E>> fcast_hierarchy;
+
+        B() { Fcast::set_id<B>(); }
+    };
+
+    struct C : public A
+    {
+        typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+        C() { Fcast::set_id<C>(); }
+    };
+
+    struct D : public B
+    {
+        typedef fastcast::hierarchy<B> fcast_hierarchy;
+
+        D() { Fcast::set_id<D>(); }
+    };
+
+    struct E : public B
+    {
+        typedef fastcast::hierarchy<B> fcast_hierarchy;
+
+        E() { Fcast::set_id<E>(); }
+    };
+
+    inline unsigned long long fast_cast(const std::vector<A *> & v)
+    {
+        unsigned long long s = 0;
+        for (auto p : v)
+        {
+            s += Fcast::cast<B>(p) ? 1 : 0;
+        }
+
+        return s;
+    }
+
+    // Time L loops of Fcast::cast<B> over N objects (the same random mix in each translation unit)
+    inline unsigned long long bench_cast(unsigned int L, std::size_t N)
+    {
+        std::vector<A *> v;
+
+        std::srand(0);
+        v.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            switch (std::rand() % 5)
+            {
+            case 0: v.push_back(new A); break;
+            case 1: v.push_back(new B); break;
+            case 2: v.push_back(new C); break;
+            case 3: v.push_back(new D); break;
+            default: v.push_back(new E); break;
+            }
+        }
+
+        const unsigned long long mean = bench(L, [&]() { return fast_cast(v); });
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+
+        return mean;
+    }
+}
+
+#endif // __BENCH_PROFILE_HXX__
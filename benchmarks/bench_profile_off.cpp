@@ -0,0 +1,12 @@
+// The translation unit of bench_profile.cpp built without FASTCAST_PROFILE
+
+#undef FASTCAST_PROFILE
+#undef FASTCAST_PROFILE_CYCLES
+
+#define BENCH_PROFILE_NS unprofiled
+#include "bench_profile.hxx"
+
+unsigned long long bench_unprofiled_cast(unsigned int L, std::size_t N)
+{
+    return unprofiled::bench_cast(L, N);
+}
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "fastcast.hxx"
+#include "bench_perf.hxx"
+
+// Generated hierarchies: Tree<Fanout, Depth, Cross> is a complete tree where each node at a level lower than Depth - 1
+// has Fanout children. When Cross is true, the leaves derive from a second root Other<T> too.
+template<unsigned int Fanout, unsigned int Depth, bool Cross>
+struct Tree
+{
+    static_assert(Depth >= 2, "The tree must have at least two levels");
+
+    constexpr static unsigned int fanout = Fanout;
+    constexpr static unsigned int depth = Depth;
+    constexpr static bool cross = Cross;
+
+    // The number of nodes in a subtree whose root is at level L
+    constexpr static unsigned int size(unsigned int L)
+        {
+            return L == Depth ? 0 : 1 + Fanout * size(L + 1);
+        }
+
+    // The number of nodes at level L
+    constexpr static unsigned int width(unsigned int L)
+        {
+            return L == 0 ? 1 : Fanout * width(L - 1);
+        }
+
+    // The position in prefix order of the P-th node of level L
+    constexpr static unsigned int pre(unsigned int L, unsigned int P)
+        {
+            return L == 0 ? 0 : pre(L - 1, P / Fanout) + 1 + (P % Fanout) * size(L);
+        }
+};
+
+template<typename T, unsigned int L, unsigned int P, int Kind = (L == 0 ? 0 : ((L + 1 == T::depth && T::cross) ? 2 : 1))>
+struct Node;
+
+template<typename T>
+struct Other;
+
+template<typename T>
+using Root = Node<T, 0, 0>;
+
+template<typename T>
+using Fcast = fastcast::fcast<Root<T>, uint64_t>;
+
+template<typename T, unsigned int L, unsigned int P, typename I>
+struct _kids;
+
+template<typename T, unsigned int L, unsigned int P, std::size_t... I>
+struct _kids<T, L, P, fastcast::_indices<I...>>
+{
+    typedef fastcast::children<Node<T, L + 1, P * T::fanout + I>...> type;
+};
+
+template<typename T, unsigned int L, unsigned int P>
+using Kids = typename std::conditional<(L + 1 < T::depth), typename _kids<T, L, P, typename fastcast::_make_indices<T::fanout>::type>::type, void>::type;
+
+template<typename T, typename I>
+struct _leaves;
+
+template<typename T, std::size_t... I>
+struct _leaves<T, fastcast::_indices<I...>>
+{
+    typedef fastcast::children<Node<T, T::depth - 1, I>...> type;
+};
+
+// LLVM-style RTTI: the nodes are numbered in prefix order so a subtree is a range of kinds
+template<typename T, unsigned int L, unsigned int P>
+struct Kind
+{
+    constexpr static unsigned int first = T::pre(L, P);
+    constexpr static unsigned int last = first + T::size(L);
+
+    static bool classof(const Root<T> * r)
+        {
+            return r->kind >= first && r->kind < last;
+        }
+};
+
+template<typename T>
+struct Node<T, 0, 0, 0> : public Fcast<T>, public Kind<T, 0, 0>
+{
+    typedef fastcast::hierarchy<fastcast::root, Kids<T, 0, 0>> fcast_hierarchy;
+
+    unsigned int kind;
+
+    Node() : kind(0) { }
+    virtual ~Node() { }
+};
+
+template<typename T, unsigned int L, unsigned int P>
+struct Node<T, L, P, 1> : public Node<T, L - 1, P / T::fanout>, public Kind<T, L, P>
+{
+    typedef fastcast::hierarchy<Node<T, L - 1, P / T::fanout>, Kids<T, L, P>> fcast_hierarchy;
+    using Kind<T, L, P>::classof;
+
+    Node() { this->kind = T::pre(L, P); }
+};
+
+template<typename T, unsigned int L, unsigned int P>
+struct Node<T, L, P, 2> : public Node<T, L - 1, P / T::fanout>, public Other<T>, public Kind<T, L, P>
+{
+    typedef fastcast::hierarchy<fastcast::parents<Node<T, L - 1, P / T::fanout>, Other<T>>> fcast_hierarchy;
+    using Kind<T, L, P>::classof;
+
+    Node() { this->kind = T::pre(L, P); }
+};
+
+template<typename T>
+struct Other : public fastcast::fcast<Other<T>, uint64_t>
+{
+    typedef fastcast::hierarchy<fastcast::root, typename _leaves<T, typename fastcast::_make_indices<T::width(T::depth - 1)>::type>::type> fcast_hierarchy;
+
+    virtual ~Other() { }
+};
+
+// The result of a measure
+struct record
+{
+    std::string hierarchy;
+    std::string workload;
+    std::string method;
+    double ns;
+    double cycles;
+    double instructions;
+    double branch_misses;
+    unsigned long long hits;
+};
+
+struct options
+{
+    std::size_t N = 1 << 20;
+    unsigned int L = 10;
+    std::string csv;
+    std::string json;
+};
+
+// Run L times func over the array and keep the fastest run
+template<typename F>
+record measure(const options & opt, perf_counters & counters, const char * hierarchy, const char * workload, const char * method, F func)
+{
+    record r { hierarchy, workload, method, 0, -1, -1, -1, 0 };
+    double best = -1;
+    for (unsigned int i = 0; i < opt.L; ++i)
+    {
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        r.hits = func();
+        auto end = std::chrono::steady_clock::now();
+        counters.stop();
+
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / opt.N;
+        if (best < 0 || ns < best)
+        {
+            best = ns;
+            if (counters.valid())
+            {
+                r.cycles = (double)counters[perf_counters::cycles] / opt.N;
+                r.instructions = (double)counters[perf_counters::instructions] / opt.N;
+                r.branch_misses = (double)counters[perf_counters::branch_misses] / opt.N;
+            }
+        }
+    }
+    r.ns = best;
+
+    std::cout << hierarchy << " | " << workload << " | " << method << ": " << r.ns << " ns";
+    if (counters.valid())
+    {
+        std::cout << ", " << r.cycles << " cycles, " << r.instructions << " instructions, " << r.branch_misses << " branch-misses";
+    }
+    std::cout << " (by cast, " << r.hits << " hits)" << std::endl;
+
+    return r;
+}
+
+template<typename T, typename C>
+Root<T> * create()
+{
+    return fastcast::make<C>();
+}
+
+template<typename T, typename... C>
+std::vector<Root<T> * (*)()> creators(fastcast::type_list<C...>)
+{
+    return { &create<T, C>... };
+}
+
+template<typename T, typename Target>
+unsigned long long with_dynamic_cast(const std::vector<Root<T> *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += dynamic_cast<Target *>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+// Only the exact type is tested: this is a lower bound for a cast based on type_info
+template<typename T, typename Target>
+unsigned long long with_typeid(const std::vector<Root<T> *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += typeid(*p) == typeid(Target) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T, typename Target>
+unsigned long long with_classof(const std::vector<Root<T> *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += (Target::classof(p) ? static_cast<Target *>(p) : nullptr) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T, typename Target>
+unsigned long long with_fastcast(const std::vector<Root<T> *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += Fcast<T>::template cast<Target>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T, typename Target>
+unsigned long long with_cross_cast(const std::vector<Root<T> *> & v)
+{
+    unsigned long long s = 0;
+    for (auto p : v)
+    {
+        s += fastcast::cross_cast<Target>(p) ? 1 : 0;
+    }
+
+    return s;
+}
+
+template<typename T>
+void cross_casts(const options &, perf_counters &, const char *, const char *, const std::vector<Root<T> *> &, std::vector<record> &, std::false_type)
+{
+}
+
+template<typename T>
+void cross_casts(const options & opt, perf_counters & counters, const char * hierarchy, const char * workload, const std::vector<Root<T> *> & v, std::vector<record> & records, std::true_type)
+{
+    records.push_back(measure(opt, counters, hierarchy, workload, "dynamic_cast<Other>", [&]() { return with_dynamic_cast<T, Other<T>>(v); }));
+    records.push_back(measure(opt, counters, hierarchy, workload, "fastcast::cross_cast<Other>", [&]() { return with_cross_cast<T, Other<T>>(v); }));
+}
+
+// The casts to the first node at the middle level on three workloads:
+// - mixed: all the classes in a random order (unpredictable outcome);
+// - hit: only the classes derived from the target;
+// - miss: only the classes which are not derived from the target.
+// The objects are allocated in a random order and the array is shuffled, so the objects are not in the cache.
+template<typename T>
+void run(const options & opt, perf_counters & counters, const char * hierarchy, std::vector<record> & records)
+{
+    typedef Node<T, T::depth / 2, 0> Target;
+    typedef Kind<T, T::depth / 2, 0> TargetKind;
+    typedef typename fastcast::hierarchy_of<Root<T>>::type classes;
+
+    const auto make = creators<T>(classes());
+    std::mt19937 gen(0);
+
+    const char * workloads[] = { "mixed", "hit", "miss" };
+    for (int w = 0; w < 3; ++w)
+    {
+        std::vector<unsigned int> kinds;
+        for (unsigned int k = 0; k < make.size(); ++k)
+        {
+            const bool in = k >= TargetKind::first && k < TargetKind::last;
+            if (w == 0 || (w == 1 && in) || (w == 2 && !in))
+            {
+                kinds.push_back(k);
+            }
+        }
+
+        std::vector<Root<T> *> v(opt.N);
+        for (auto & p : v)
+        {
+            p = make[kinds[gen() % kinds.size()]]();
+        }
+        std::shuffle(v.begin(), v.end(), gen);
+
+        records.push_back(measure(opt, counters, hierarchy, workloads[w], "dynamic_cast", [&]() { return with_dynamic_cast<T, Target>(v); }));
+        records.push_back(measure(opt, counters, hierarchy, workloads[w], "typeid", [&]() { return with_typeid<T, Target>(v); }));
+        records.push_back(measure(opt, counters, hierarchy, workloads[w], "classof", [&]() { return with_classof<T, Target>(v); }));
+        records.push_back(measure(opt, counters, hierarchy, workloads[w], "fastcast", [&]() { return with_fastcast<T, Target>(v); }));
+        cross_casts<T>(opt, counters, hierarchy, workloads[w], v, records, std::integral_constant<bool, T::cross>());
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+}
+
+// A CSV field is quoted when it contains a comma, a quote or a line break (the quotes are doubled)
+std::string csv_field(const std::string & s)
+{
+    if (s.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        return s;
+    }
+
+    std::string quoted = "\"";
+    for (const char c : s)
+    {
+        quoted += c == '"' ? "\"\"" : std::string(1, c);
+    }
+
+    return quoted + '"';
+}
+
+// A JSON string with the quotes, the backslashes and the control characters escaped
+std::string json_string(const std::string & s)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string escaped = "\"";
+    for (const char c : s)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (u < 0x20)
+        {
+            escaped += "\\u00";
+            escaped += digits[u >> 4];
+            escaped += digits[u & 0xF];
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+
+    return escaped + '"';
+}
+
+// The counters which are not available are empty
+void write_csv(const std::string & path, const std::vector<record> & records)
+{
+    std::ofstream out(path);
+    out << "hierarchy,workload,method,ns,cycles,instructions,branch_misses,hits" << std::endl;
+    for (const auto & r : records)
+    {
+        out << csv_field(r.hierarchy) << ',' << csv_field(r.workload) << ',' << csv_field(r.method) << ',' << r.ns << ',';
+        if (r.cycles >= 0)
+        {
+            out << r.cycles << ',' << r.instructions << ',' << r.branch_misses;
+        }
+        else
+        {
+            out << ",,";
+        }
+        out << ',' << r.hits << std::endl;
+    }
+}
+
+// The counters which are not available are null
+void write_json(const std::string & path, const std::vector<record> & records)
+{
+    std::ofstream out(path);
+    out << "[" << std::endl;
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        const record & r = records[i];
+        out << "  { \"hierarchy\": " << json_string(r.hierarchy) << ", \"workload\": " << json_string(r.workload) << ", \"method\": " << json_string(r.method) << ", \"ns\": " << r.ns;
+        if (r.cycles >= 0)
+        {
+            out << ", \"cycles\": " << r.cycles << ", \"instructions\": " << r.instructions << ", \"branch_misses\": " << r.branch_misses;
+        }
+        else
+        {
+            out << ", \"cycles\": null, \"instructions\": null, \"branch_misses\": null";
+        }
+        out << ", \"hits\": " << r.hits << " }" << (i + 1 < records.size() ? "," : "") << std::endl;
+    }
+    out << "]" << std::endl;
+}
+
+// bench_suite [number of objects] [number of runs] [--csv file] [--json file]
+int main(int argc, char ** argv)
+{
+    options opt;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+        {
+            opt.csv = argv[++i];
+        }
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+        {
+            opt.json = argv[++i];
+        }
+        else if (positional++ == 0)
+        {
+            opt.N = std::atol(argv[i]);
+        }
+        else
+        {
+            opt.L = std::atol(argv[i]);
+        }
+    }
+
+    perf_counters counters;
+    if (!counters.valid())
+    {
+        std::cout << "The hardware counters are not available (have a look at /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+    }
+
+    std::vector<record> records;
+    run<Tree<1, 16, false>>(opt, counters, "chain(16)", records);
+    run<Tree<2, 8, false>>(opt, counters, "binary(depth=8)", records);
+    run<Tree<4, 4, false>>(opt, counters, "tree(fanout=4,depth=4)", records);
+    run<Tree<3, 3, true>>(opt, counters, "cross(fanout=3,depth=3)", records);
+
+    if (!opt.csv.empty())
+    {
+        write_csv(opt.csv, records);
+    }
+    if (!opt.json.empty())
+    {
+        write_json(opt.json, records);
+    }
+
+    return 0;
+}
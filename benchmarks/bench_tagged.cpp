@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <random>
+
+#include "fastcast_tagged.hxx"
+#include "bench_common.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using Fcast = fastcast::fcast<A, uint16_t>;
+
+// The number of neighbors of a node
+constexpr unsigned int K = 8;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C, D>> fcast_hierarchy;
+
+    // the neighbors with raw and tagged pointers
+    A * raw[K];
+    fastcast::tagged_ptr<A> tagged[K];
+    unsigned int value;
+
+    A() : value(1) { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<E, F>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<H>> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public C
+{
+    typedef fastcast::hierarchy<C> fcast_hierarchy;
+    G() { Fcast::set_id<G>(); }
+};
+
+struct H : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    H() { Fcast::set_id<H>(); }
+};
+
+// Walk S steps in the graph: the next node is the first neighbor which is an instance of E (or the last neighbor)
+// so the neighbors are tested but only the next node is read
+unsigned long long walk_raw(A * a, std::size_t S)
+{
+    unsigned long long n = 0;
+    for (std::size_t s = 0; s < S; ++s)
+    {
+        A * next = a->raw[K - 1];
+        for (A * c : a->raw)
+        {
+            if (Fcast::instanceof<E>(c))
+            {
+                next = c;
+                break;
+            }
+        }
+        n += next->value;
+        a = next;
+    }
+
+    return n;
+}
+
+unsigned long long walk_tagged(fastcast::tagged_ptr<A> a, std::size_t S)
+{
+    unsigned long long n = 0;
+    for (std::size_t s = 0; s < S; ++s)
+    {
+        fastcast::tagged_ptr<A> next = a->tagged[K - 1];
+        for (const fastcast::tagged_ptr<A> & c : a->tagged)
+        {
+            if (fastcast::instanceof<E>(c))
+            {
+                next = c;
+                break;
+            }
+        }
+        n += next->value;
+        a = next;
+    }
+
+    return n;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<A *> v(N);
+        std::mt19937 gen(0);
+
+        for (auto & p : v)
+        {
+            switch (gen() % 8)
+            {
+            case 0: p = new B; break;
+            case 1: p = new E; break;
+            case 2: p = new F; break;
+            case 3: p = new C; break;
+            case 4: p = new G; break;
+            case 5: p = new D; break;
+            case 6: p = new H; break;
+            default: p = new A; break;
+            }
+        }
+        // the neighbors of a node are spread in memory
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            for (unsigned int k = 0; k < K; ++k)
+            {
+                v[i]->raw[k] = v[gen() % N];
+                v[i]->tagged[k] = fastcast::tagged_ptr<A>(v[i]->raw[k]);
+            }
+        }
+
+        std::cout << "Walk with the raw pointers (Fcast::instanceof reads the tested neighbors):" << std::endl;
+        const unsigned long long mean1 = bench(L, [&]() { return walk_raw(v[0], N); });
+
+        std::cout << "Walk with fastcast::tagged_ptr (only the next node is read):" << std::endl;
+        const unsigned long long mean2 = bench(L, [&]() { return walk_tagged(fastcast::tagged_ptr<A>(v[0]), N); });
+
+        compare("fastcast::tagged_ptr", mean1, mean2);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
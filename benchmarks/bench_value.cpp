@@ -0,0 +1,183 @@
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#include "fastcast_value.hxx"
+#include "bench_common.hxx"
+
+// Small shapes which are only stored by value
+struct Shape;
+struct Circle;
+struct Rect;
+struct Square;
+struct Triangle;
+
+using Fcast = fastcast::fcast<Shape, uint8_t>;
+
+struct Shape : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<Circle, Rect, Triangle>> fcast_hierarchy;
+    float x, y;
+    Shape(float _x, float _y) : x(_x), y(_y) { }
+    virtual ~Shape() { }
+    virtual float area() const { return 0; }
+};
+
+struct Circle : public Shape
+{
+    typedef fastcast::hierarchy<Shape> fcast_hierarchy;
+    float r;
+    Circle(float _x, float _y, float _r) : Shape(_x, _y), r(_r) { }
+    float area() const override { return 3.14159f * r * r; }
+};
+
+struct Rect : public Shape
+{
+    typedef fastcast::hierarchy<Shape, fastcast::children<Square>> fcast_hierarchy;
+    float w, h;
+    Rect(float _x, float _y, float _w, float _h) : Shape(_x, _y), w(_w), h(_h) { }
+    float area() const override { return w * h; }
+};
+
+struct Square : public Rect
+{
+    typedef fastcast::hierarchy<Rect> fcast_hierarchy;
+    Square(float _x, float _y, float _w) : Rect(_x, _y, _w, _w) { }
+};
+
+struct Triangle : public Shape
+{
+    typedef fastcast::hierarchy<Shape> fcast_hierarchy;
+    float a, b, c;
+    Triangle(float _x, float _y, float _a, float _b, float _c) : Shape(_x, _y), a(_a), b(_b), c(_c) { }
+    float area() const override { return a * b * c; }
+};
+
+using Value = fastcast::poly_value<Shape, 32, 8>;
+
+template<typename P, typename F>
+void fill(std::vector<P> & v, std::size_t N, F make)
+{
+    std::mt19937 gen(0);
+    v.clear();
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const float f = static_cast<float>(i & 0xFF);
+        v.push_back(make(gen() % 4, f));
+    }
+}
+
+std::unique_ptr<Shape> make_pointer(unsigned int k, float f)
+{
+    switch (k)
+    {
+    case 0: return std::unique_ptr<Shape>(fastcast::make<Circle>(f, f, f));
+    case 1: return std::unique_ptr<Shape>(fastcast::make<Rect>(f, f, f, 2 * f));
+    case 2: return std::unique_ptr<Shape>(fastcast::make<Square>(f, f, f));
+    default: return std::unique_ptr<Shape>(fastcast::make<Triangle>(f, f, f, f, f));
+    }
+}
+
+Value make_value(unsigned int k, float f)
+{
+    switch (k)
+    {
+    case 0: return Value::make<Circle>(f, f, f);
+    case 1: return Value::make<Rect>(f, f, f, 2 * f);
+    case 2: return Value::make<Square>(f, f, f);
+    default: return Value::make<Triangle>(f, f, f, f, f);
+    }
+}
+
+// Add up the positions (iterate) and the areas (a virtual call) and count the rectangles (a type test)
+template<typename P>
+unsigned long long iterate(const std::vector<P> & v)
+{
+    float s = 0;
+    for (const auto & p : v)
+    {
+        s += p->x + p->y;
+    }
+
+    return static_cast<unsigned long long>(s);
+}
+
+template<typename P>
+unsigned long long dispatch(const std::vector<P> & v)
+{
+    float s = 0;
+    for (const auto & p : v)
+    {
+        s += p->area();
+    }
+
+    return static_cast<unsigned long long>(s);
+}
+
+unsigned long long count_rects(const std::vector<std::unique_ptr<Shape>> & v)
+{
+    unsigned long long n = 0;
+    for (const auto & p : v)
+    {
+        n += Fcast::instanceof<Rect>(p.get());
+    }
+
+    return n;
+}
+
+unsigned long long count_rects(const std::vector<Value> & v)
+{
+    unsigned long long n = 0;
+    for (const auto & p : v)
+    {
+        n += fastcast::instanceof<Rect>(p);
+    }
+
+    return n;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc >= 3)
+    {
+        unsigned int L = std::atol(argv[1]);
+        std::size_t N = std::atol(argv[2]);
+        std::vector<std::unique_ptr<Shape>> pointers;
+        std::vector<Value> values;
+        unsigned long long mean1, mean2;
+
+        std::cout << "Build a std::vector<std::unique_ptr<Shape>>:" << std::endl;
+        mean1 = bench(L, [&]() { fill(pointers, N, make_pointer); return pointers.size(); });
+
+        std::cout << "Build a std::vector<fastcast::poly_value<Shape, 32, 8>>:" << std::endl;
+        mean2 = bench(L, [&]() { fill(values, N, make_value); return values.size(); });
+
+        compare("fastcast::poly_value", mean1, mean2);
+
+        std::cout << "Iterate over the std::unique_ptr:" << std::endl;
+        mean1 = bench(L, [&]() { return iterate(pointers); });
+
+        std::cout << "Iterate over the fastcast::poly_value:" << std::endl;
+        mean2 = bench(L, [&]() { return iterate(values); });
+
+        compare("fastcast::poly_value", mean1, mean2);
+
+        std::cout << "Virtual call on the std::unique_ptr:" << std::endl;
+        mean1 = bench(L, [&]() { return dispatch(pointers); });
+
+        std::cout << "Virtual call on the fastcast::poly_value:" << std::endl;
+        mean2 = bench(L, [&]() { return dispatch(values); });
+
+        compare("fastcast::poly_value", mean1, mean2);
+
+        std::cout << "Fcast::instanceof on the std::unique_ptr:" << std::endl;
+        mean1 = bench(L, [&]() { return count_rects(pointers); });
+
+        std::cout << "fastcast::instanceof on the fastcast::poly_value:" << std::endl;
+        mean2 = bench(L, [&]() { return count_rects(values); });
+
+        compare("fastcast::poly_value", mean1, mean2);
+    }
+
+    return 0;
+}
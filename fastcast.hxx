@@ -31,9 +31,28 @@
 # error "Fastcast must be used with C++11"
 #else
 
+#include <atomic>
 #include <cinttypes>
+#include <cstddef>
 #include <exception>
+#include <new>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+// Define FASTCAST_PROFILE to count the calls to instanceof, same and cast (have a look at fastcast_profile.hxx)
+#if defined(FASTCAST_PROFILE)
+# include "fastcast_profile.hxx"
+#endif
+
+// Define FASTCAST_NO_SIMD to disable the vectorized kernels used by the batch functions
+// (immintrin.h is long to parse, so the SSE2 kernels only include emmintrin.h)
+#if !defined(FASTCAST_NO_SIMD) && (defined(__AVX512F__) || defined(__AVX2__))
+# include <immintrin.h>
+#elif !defined(FASTCAST_NO_SIMD) && defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 /**
  * The basic idea is to find a single uint to identify a class and to be able to easily determinate if a class
@@ -69,6 +88,100 @@ namespace fastcast
     // The type used for fcast_id
     typedef uint64_t fcast_id_t;
 
+    // The type used to compute the ids at compile time: the widest unsigned integer type available
+    // (ids longer than 64 bits can only be stored in a fcast<T, unsigned __int128>)
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 _wide_id_t;
+#else
+    typedef uint64_t _wide_id_t;
+#endif
+
+    // The type used to test the ids at runtime: the id type itself when it is wider than 64 bits, else uint64_t
+    template<typename U>
+    struct _word_
+    {
+        typedef typename std::remove_cv<U>::type id_type;
+        typedef typename std::conditional<(sizeof(id_type) > sizeof(uint64_t)), id_type, uint64_t>::type type;
+    };
+
+    // A list of types
+    template<typename...>
+    struct type_list
+    {
+        constexpr static std::size_t size = 0;
+    };
+
+    template<typename U, typename... C>
+    struct type_list<U, C...>
+    {
+        constexpr static std::size_t size = 1 + sizeof...(C);
+    };
+
+    // Concatenation of two lists
+    template<typename L1, typename L2>
+    struct _concat;
+
+    template<typename... U, typename... V>
+    struct _concat<type_list<U...>, type_list<V...>>
+    {
+        typedef type_list<U..., V...> type;
+    };
+
+    /**
+     * @return the smallest argument
+     */
+    constexpr std::size_t _min_pos(std::size_t a, std::size_t b) noexcept
+    {
+        return a < b ? a : b;
+    }
+
+    // The position of the first true value in B (the number of values if none)
+    // The lookups are flat (a pack expansion and a divide and conquer search with a logarithmic depth)
+    // rather than a recursion on the pack, so the cost of the instantiations does not grow with the position.
+    template<bool... B>
+    struct _first_true
+    {
+        constexpr static bool values[sizeof...(B) + 1] = { B..., true };
+
+        constexpr static std::size_t find(std::size_t lo, std::size_t hi) noexcept
+            {
+                return hi - lo == 1 ? (values[lo] ? lo : sizeof...(B)) : _min_pos(find(lo, lo + (hi - lo) / 2), find(lo + (hi - lo) / 2, hi));
+            }
+    };
+
+    template<bool... B>
+    constexpr bool _first_true<B...>::values[sizeof...(B) + 1];
+
+    // The position of V in a list (the size of the list if V is not in it)
+    template<typename V, typename L>
+    struct _position;
+
+    template<typename V, typename... C>
+    struct _position<V, type_list<C...>>
+    {
+        constexpr static std::size_t value = _first_true<std::is_same<V, C>::value...>::find(0, sizeof...(C) + 1);
+    };
+
+    // A sequence of integers: _make_indices<N>::type is _indices<0, ..., N - 1>
+    template<std::size_t... I>
+    struct _indices
+    {
+        typedef _indices<I..., (I + sizeof...(I))...> twice;
+        typedef _indices<I..., sizeof...(I)> next;
+    };
+
+    template<std::size_t N>
+    struct _make_indices
+    {
+        typedef typename std::conditional<N % 2 == 0, typename _make_indices<N / 2>::type::twice, typename _make_indices<N / 2>::type::twice::next>::type type;
+    };
+
+    template<>
+    struct _make_indices<0>
+    {
+        typedef _indices<> type;
+    };
+
     struct root
     {
         struct fcast_hierarchy
@@ -84,6 +197,12 @@ namespace fastcast
                             {
                                 return 0;
                             }
+
+                        template<typename U>
+                        constexpr static _wide_id_t code() noexcept
+                            {
+                                return 0;
+                            }
                     };
                 };
             };
@@ -95,6 +214,12 @@ namespace fastcast
                     {
                         return 1;
                     }
+
+                template<typename U>
+                constexpr static _wide_id_t code() noexcept
+                    {
+                        return 1;
+                    }
             };
 
             template<typename T>
@@ -153,18 +278,60 @@ namespace fastcast
     /**
      * @return the number of bits used to represent the argument
      */
-    constexpr unsigned int number_of_bits(unsigned int n) noexcept
+    constexpr unsigned int number_of_bits(_wide_id_t n) noexcept
     {
         return n == 0 ? 0 : (1 + number_of_bits(n >> 1));
     }
 
+    /**
+     * @return a mask covering all the bits used to represent the argument
+     */
+    constexpr _wide_id_t id_mask(_wide_id_t id) noexcept
+    {
+        return id == 0 ? 0 : ((id_mask(id >> 1) << 1) | 1);
+    }
+
+    /**
+     * @return the number of bits set in x
+     */
+    inline unsigned int popcount(uint64_t x) noexcept
+    {
+#if defined(__GNUC__)
+        return __builtin_popcountll(x);
+#else
+        unsigned int n = 0;
+        for (; x; x &= x - 1)
+        {
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    /**
+     * @return the position of the lowest bit set in x (x must not be 0)
+     */
+    inline unsigned int lowest_bit(uint64_t x) noexcept
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#else
+        unsigned int n = 0;
+        for (; !(x & 1); x >>= 1)
+        {
+            ++n;
+        }
+        return n;
+#endif
+    }
+
     /**
      * @return the corrected position of a child in children list
      */
     template<typename U, typename V>
-    constexpr unsigned int corrected_pos() noexcept
+    constexpr _wide_id_t corrected_pos() noexcept
     {
-        return (U::template pos<void>() == 0 ? 0 : (U::template pos<V>() - 1) | (1 << number_of_bits(U::template pos<void>() - 1)));
+        return U::template code<V>();
     }
 
     // The id of a child according to its position in the list of the parent's children
@@ -172,79 +339,295 @@ namespace fastcast
     template<typename T, typename Me>
     struct _fcast_id_
     {
-        constexpr static fcast_id_t id = (corrected_pos<typename _get_parent<T, typename Me::fcast_hierarchy::parent>::type::fcast_hierarchy::children, Me>() << Me::fcast_hierarchy::template number_of_bits<T>()) | _fcast_id_<T, typename _get_parent<T, typename Me::fcast_hierarchy::parent>::type>::id;
+        static_assert(Me::fcast_hierarchy::template number_of_bits<T>() + number_of_bits(corrected_pos<typename _get_parent<T, typename Me::fcast_hierarchy::parent>::type::fcast_hierarchy::children, Me>()) <= 8 * sizeof(_wide_id_t), "The hierarchy is too deep: the ids do not fit in the widest integer type");
+
+        constexpr static _wide_id_t id = (static_cast<_wide_id_t>(corrected_pos<typename _get_parent<T, typename Me::fcast_hierarchy::parent>::type::fcast_hierarchy::children, Me>()) << Me::fcast_hierarchy::template number_of_bits<T>()) | _fcast_id_<T, typename _get_parent<T, typename Me::fcast_hierarchy::parent>::type>::id;
     };
 
     // Partial specialization of the template function _fcast_id_<T, Me>
     template<typename T>
     struct _fcast_id_<T, root>
     {
-        constexpr static fcast_id_t id = 0;
+        constexpr static _wide_id_t id = 0;
     };
 
     // Partial specialization of the template function _fcast_id_<T, Me>
     template<typename T>
     struct _fcast_id_<T, root::fcast_hierarchy::parent>
     {
-        constexpr static fcast_id_t id = 0;
+        constexpr static _wide_id_t id = 0;
     };
 
     /**
      * @return the id of the parent
      */
     template<typename T, typename U>
-    constexpr fcast_id_t base_id() noexcept
+    constexpr _wide_id_t base_id() noexcept
     {
-        return (corrected_pos<typename _get_parent<T, typename U::fcast_hierarchy::parent>::type::fcast_hierarchy::children, void>() << U::fcast_hierarchy::template number_of_bits<T>()) | _fcast_id_<T, typename _get_parent<T, typename U::fcast_hierarchy::parent>::type>::id;
+        return (static_cast<_wide_id_t>(corrected_pos<typename _get_parent<T, typename U::fcast_hierarchy::parent>::type::fcast_hierarchy::children, void>()) << U::fcast_hierarchy::template number_of_bits<T>()) | _fcast_id_<T, typename _get_parent<T, typename U::fcast_hierarchy::parent>::type>::id;
     }
 
-    // Define _children struct
-    template<unsigned int, typename...>
-    struct _children;
+    // A child with a weight: the relative frequency of its instances
+    // When at least one child is weighted, the children of a class get Huffman codes (the other ones have a weight of 1):
+    // the most frequent classes get the shortest ids.
+    template<typename C, uint64_t W>
+    struct weight
+    {
+        typedef C type;
+        constexpr static uint64_t value = W;
+    };
+
+    template<typename C>
+    struct _unweight
+    {
+        typedef C type;
+        constexpr static uint64_t value = 1;
+        constexpr static bool weighted = false;
+    };
+
+    template<typename C, uint64_t W>
+    struct _unweight<weight<C, W>>
+    {
+        typedef C type;
+        constexpr static uint64_t value = W;
+        constexpr static bool weighted = true;
+    };
+
+    template<typename... C>
+    struct _is_weighted : std::integral_constant<bool, (_first_true<_unweight<C>::weighted...>::find(0, sizeof...(C) + 1) < sizeof...(C))>
+    {
+    };
+
+    // A node of the Huffman tree: its weight and the set of its leaves
+    template<uint64_t W, uint64_t M>
+    struct _hnode
+    {
+        constexpr static uint64_t weight = W;
+        constexpr static uint64_t mask = M;
+    };
+
+    // The lightest node of a list (the first one in case of tie)
+    template<typename L>
+    struct _hmin;
+
+    template<typename N>
+    struct _hmin<type_list<N>>
+    {
+        typedef N type;
+    };
+
+    template<typename N, typename... Ns>
+    struct _hmin<type_list<N, Ns...>>
+    {
+        typedef typename _hmin<type_list<Ns...>>::type next;
+        typedef typename std::conditional<(next::weight < N::weight), next, N>::type type;
+    };
+
+    // Remove the node with the mask M from a list
+    template<uint64_t M, typename L>
+    struct _hremove;
+
+    template<bool Found, uint64_t M, typename N, typename... Ns>
+    struct _hremove_
+    {
+        typedef type_list<Ns...> type;
+    };
+
+    template<uint64_t M, typename N, typename... Ns>
+    struct _hremove_<false, M, N, Ns...>
+    {
+        typedef typename _concat<type_list<N>, typename _hremove<M, type_list<Ns...>>::type>::type type;
+    };
+
+    template<uint64_t M>
+    struct _hremove<M, type_list<>>
+    {
+        typedef type_list<> type;
+    };
 
-    // Define recursively the chidlren using a variadic template
-    template<unsigned int N, typename U, typename... C>
-    struct _children<N, U, C...>
+    template<uint64_t M, typename N, typename... Ns>
+    struct _hremove<M, type_list<N, Ns...>> : _hremove_<N::mask == M, M, N, Ns...>
     {
-        typedef _children<N + 1, C...> __children__;
+    };
 
+    // The masks of the merged nodes: the length of the code of a leaf is the number of merged nodes containing it
+    template<uint64_t... H>
+    struct _hmerged
+    {
         /**
-         * @return the position of a child in children list
+         * @return the length of the code of the i-th leaf
          */
-        template<typename V>
-        constexpr static unsigned int pos() noexcept
+        constexpr static unsigned int length(unsigned int i) noexcept
+            {
+                return _count(i, H...);
+            }
+
+    private:
+
+        constexpr static unsigned int _count(unsigned int) noexcept
+            {
+                return 0;
+            }
+
+        template<typename... M>
+        constexpr static unsigned int _count(unsigned int i, uint64_t m, M... ms) noexcept
+            {
+                return static_cast<unsigned int>((m >> i) & 1) + _count(i, ms...);
+            }
+    };
+
+    // Merge the two lightest nodes until only one remains
+    template<typename L, uint64_t... H>
+    struct _huffman;
+
+    template<typename N, uint64_t... H>
+    struct _huffman<type_list<N>, H...>
+    {
+        typedef _hmerged<H...> type;
+    };
+
+    template<typename N1, typename N2, typename... Ns, uint64_t... H>
+    struct _huffman<type_list<N1, N2, Ns...>, H...>
+    {
+        typedef typename _hmin<type_list<N1, N2, Ns...>>::type a;
+        typedef typename _hremove<a::mask, type_list<N1, N2, Ns...>>::type without_a;
+        typedef typename _hmin<without_a>::type b;
+        typedef typename _hremove<b::mask, without_a>::type without_ab;
+        typedef typename _huffman<typename _concat<without_ab, type_list<_hnode<a::weight + b::weight, a::mask | b::mask>>>::type, H..., (a::mask | b::mask)>::type type;
+    };
+
+    // The leaves of the Huffman tree
+    template<typename I, uint64_t... W>
+    struct _hleaves;
+
+    template<std::size_t... I, uint64_t... W>
+    struct _hleaves<_indices<I...>, W...>
+    {
+        typedef type_list<_hnode<W, uint64_t(1) << I>...> type;
+    };
+
+    /**
+     * @return the L low bits of c in reverse order
+     */
+    constexpr _wide_id_t _reverse_bits(_wide_id_t c, unsigned int L) noexcept
+    {
+        return L == 0 ? 0 : (((c & 1) << (L - 1)) | _reverse_bits(c >> 1, L - 1));
+    }
+
+    /**
+     * @return the code of the position p (starting at 1) among n: p - 1 with a leading delimiter bit
+     */
+    constexpr _wide_id_t _position_code(unsigned int p, unsigned int n) noexcept
+    {
+        return (p - 1) | (_wide_id_t(1) << number_of_bits(n - 1));
+    }
+
+    // The codes of the children of a class according to their weights W
+    template<bool Weighted, uint64_t... W>
+    struct _children_code
+    {
+        /**
+         * @return the code of the child at position p: p - 1 with a leading delimiter bit
+         */
+        constexpr static _wide_id_t code(unsigned int p) noexcept
             {
-                return std::is_same<U, V>::value ? N : __children__::template pos<V>();
+                return _position_code(p, sizeof...(W));
             }
     };
 
-    // Last template used in the recursion
-    template<unsigned int N, typename U>
-    struct _children<N, U>
+    template<uint64_t... W>
+    struct _children_code<true, W...>
     {
+        static_assert(sizeof...(W) <= 64, "A class cannot have more than 64 weighted children");
+
+        typedef typename _huffman<typename _hleaves<typename _make_indices<sizeof...(W)>::type, W...>::type>::type tree;
+
         /**
-         * @return the position of a child in children list
+         * @return the code of the child at position p: its Huffman code with a leading delimiter bit
+         * The canonical Huffman code is reversed since the ids are read from the lowest bit:
+         * no code ends another one, so the suffix test in instanceof is still valid.
          */
-        template<typename V>
-        constexpr static unsigned int pos() noexcept
+        constexpr static _wide_id_t code(unsigned int p) noexcept
+            {
+                return _reverse_bits(_canonical(p - 1, 0), tree::length(p - 1)) | (_wide_id_t(1) << tree::length(p - 1));
+            }
+
+    private:
+
+        /**
+         * @return the canonical code of the i-th leaf: the codes are ordered by length and position
+         */
+        constexpr static _wide_id_t _canonical(unsigned int i, unsigned int j) noexcept
             {
-                return N;
+                return j == sizeof...(W) ? 0 : (((tree::length(j) < tree::length(i) || (tree::length(j) == tree::length(i) && j < i)) ? (_wide_id_t(1) << (tree::length(i) - tree::length(j))) : 0) + _canonical(i, j + 1));
             }
     };
 
+    // N child positions reserved for the plugin classes (see fastcast::plugin): it must be the last one in the children list
+    template<unsigned int N>
+    struct slots
+    {
+    };
+
+    template<typename C>
+    struct _slots_of : std::integral_constant<unsigned int, 0>
+    {
+    };
+
+    template<unsigned int N>
+    struct _slots_of<slots<N>> : std::integral_constant<unsigned int, N>
+    {
+    };
+
+    // The number of slots given by the last child (read in an array rather than with a recursion on the children)
+    template<typename... C>
+    struct _last_slots
+    {
+        constexpr static unsigned int values[sizeof...(C) + 1] = { _slots_of<C>::value..., 0 };
+        constexpr static unsigned int value = values[sizeof...(C) ? sizeof...(C) - 1 : 0];
+    };
+
+    template<typename... C>
+    constexpr unsigned int _last_slots<C...>::values[sizeof...(C) + 1];
+
     // Define children struct used in the hierarchy definition
     template<typename... C>
     struct children
     {
-        typedef _children<1, C...> __children__;
+        static_assert(_first_true<(_slots_of<C>::value != 0)...>::find(0, sizeof...(C) + 1) + 1 >= sizeof...(C), "fastcast::slots must be the last child");
+        static_assert(!_last_slots<C...>::value || !_is_weighted<C...>::value, "The children cannot be weighted when some slots are reserved");
+
+        // The number of slots reserved for the plugin classes
+        constexpr static unsigned int reserved = _last_slots<C...>::value;
+
+        // The number of codes: one for each child and one for each slot
+        constexpr static unsigned int size = sizeof...(C) + reserved - (reserved ? 1 : 0);
 
         /**
-         * @return the position of a child in children list
+         * @return the position of a child in children list (starting at 1, the last position if V is not a child)
          */
         template<typename V>
         constexpr static unsigned int pos() noexcept
             {
-                return __children__::template pos<V>();
+                return static_cast<unsigned int>(_min_pos(1 + _first_true<std::is_same<typename _unweight<C>::type, V>::value...>::find(0, sizeof...(C) + 1), sizeof...(C)));
+            }
+
+        /**
+         * @return the code of a child (its position or its Huffman code when the children are weighted)
+         * with a leading delimiter bit
+         */
+        template<typename V>
+        constexpr static _wide_id_t code() noexcept
+            {
+                return reserved ? _position_code(pos<V>(), size) : _children_code<_is_weighted<C...>::value, _unweight<C>::value...>::code(pos<V>());
+            }
+
+        /**
+         * @return the code of the slot k (the slots follow the children)
+         */
+        constexpr static _wide_id_t slot_code(unsigned int k) noexcept
+            {
+                return _position_code(sizeof...(C) + k, size);
             }
     };
 
@@ -258,7 +641,7 @@ namespace fastcast
         template<typename T>
         constexpr static unsigned int number_of_bits() noexcept
             {
-                return fastcast::number_of_bits(base_id<T, typename _get_parent<T, parent>::type>());
+                return fastcast::number_of_bits(_fcast_id_<T, typename _get_parent<T, parent>::type>::id);
             }
     };
 
@@ -275,61 +658,252 @@ namespace fastcast
             }
     };
 
+    // no_slot exception is thrown when a plugin class cannot get a slot in its parent
+    class no_slot : std::exception
+    {
+    public:
+
+        no_slot() : std::exception() { }
+
+        virtual const char * what() const noexcept
+            {
+                return "No slot left for a fast cast plugin";
+            }
+    };
+
+    // The hierarchy of a plugin class: a class which is not in the children list of its parent
+    // but which takes one of the slots reserved by its parent at runtime (see fastcast::plugin)
+    template<typename Parent>
+    struct plugin_hierarchy : public hierarchy<Parent>
+    {
+        typedef Parent fcast_plugin;
+    };
+
+    // true when V is a plugin class
+    template<typename V, typename = void>
+    struct _is_plugin : std::false_type { };
+
+    template<typename V>
+    struct _is_plugin<V, decltype(void(static_cast<typename V::fcast_hierarchy::fcast_plugin *>(nullptr)))> : std::is_same<typename V::fcast_hierarchy, plugin_hierarchy<typename V::fcast_hierarchy::fcast_plugin>> { };
+
+    // true when a B * can be converted to a D * with a static_cast (D derives from B and B is neither ambiguous nor virtual)
+    template<typename B, typename D, typename = void>
+    struct _static_downcast : std::false_type { };
+
+    template<typename B, typename D>
+    struct _static_downcast<B, D, decltype(void(static_cast<D *>(std::declval<B *>())))> : std::is_base_of<B, D> { };
+
+    // true when V has no child (defined with the list of the children)
+    template<typename V>
+    struct _is_leaf;
+
+    // The test of an id against the id of V (defined with _is_leaf): a mask for a class having children,
+    // an equality with a constant for a leaf, and an equality with the id given at runtime for a plugin class
+    template<typename V>
+    struct _id_test;
+
+    // Cast w to a To with the offset table of the exact id (defined with cross_cast)
+    template<typename To, typename W>
+    inline To * _cross_cast(W * w, std::false_type) noexcept;
+
+    // The number of slots of Parent already taken
+    // The counter must be shared by all the shared objects: the definitions of the template static members
+    // are unique on ELF platforms when they are exported (for example, in building the executable with -rdynamic).
+    template<typename Parent>
+    struct _slot_counter
+    {
+        static std::atomic<unsigned int> taken;
+    };
+
+    template<typename Parent>
+    std::atomic<unsigned int> _slot_counter<Parent>::taken(0);
+
+    /**
+     * A plugin class P (typically defined in a shared object loaded at runtime) derives from a class Parent
+     * having fastcast::slots in its children list and typedefs fastcast::plugin_hierarchy<Parent> as fcast_hierarchy.
+     * Its id is made with the code of the first free slot of Parent, so the instanceof test is the same as for the other classes.
+     */
+    template<typename P>
+    struct plugin
+    {
+        typedef typename P::fcast_hierarchy::fcast_plugin parent;
+        typedef typename parent::fcast_hierarchy::children children;
+
+        static_assert(children::reserved != 0, "The parent of a plugin class must reserve some slots");
+
+        /**
+         * Reserve a slot for P (once, lock-free)
+         * It should be called when the plugin is loaded to get the error as soon as possible.
+         * @return the slot of P or throw a fastcast::no_slot exception when all the slots are taken
+         */
+        static unsigned int reserve()
+            {
+                static const unsigned int k = take();
+                return k;
+            }
+
+        /**
+         * @return the id of P in the hierarchy of T (a root class or a fcast)
+         */
+        template<typename T>
+        static _wide_id_t id()
+            {
+                static const _wide_id_t _id_ = (children::slot_code(reserve()) << number_of_bits(_fcast_id_<T, parent>::id)) | _fcast_id_<T, parent>::id;
+                return _id_;
+            }
+
+    private:
+
+        static unsigned int take()
+            {
+                std::atomic<unsigned int> & taken = _slot_counter<parent>::taken;
+                unsigned int k = taken.load(std::memory_order_relaxed);
+                do
+                {
+                    if (k >= children::reserved)
+                    {
+                        throw no_slot();
+                    }
+                }
+                while (!taken.compare_exchange_weak(k, k + 1, std::memory_order_relaxed));
+
+                return k;
+            }
+    };
+
     // To be derivated to have a fcast_id
     template<typename T, typename U>
     struct fcast
     {
+        // The type of the ids and the type used to test them
+        typedef typename _word_<U>::id_type id_type;
+        typedef typename _word_<U>::type word_type;
+
         U _fcast_id;
 
         /**
-         * Set the _fcast_id field
+         * @return the id of V
          */
         template<typename V>
-        inline void set_id() noexcept
+        constexpr static word_type id() noexcept
             {
-                _fcast_id = fastcast::_fcast_id_<fcast<T, U>, V>::id;
+                static_assert(fastcast::number_of_bits(fastcast::_fcast_id_<fcast<T, U>, V>::id) <= 8 * sizeof(id_type), "The id of this class does not fit in the id type of fcast (have a look at fastcast::id_type)");
+                return static_cast<word_type>(fastcast::_fcast_id_<fcast<T, U>, V>::id);
             }
 
         /**
-         * @return true if w is an instance of V
+         * @return the id of V: id<V>() or the id given at runtime to a plugin class (see fastcast::plugin)
+         * (a plugin class takes its slot on its first use: throw a fastcast::no_slot exception when there is none left)
          */
-        template<typename V, typename W>
-        inline static bool instanceof(W * w) noexcept
+        template<typename V>
+        inline static word_type id_of() noexcept(!_is_plugin<V>::value)
             {
-                // Check if V::fcast_id ended w->fcast::_fcast_id in binary representation
-                // For example, if a=1011011 and b=1011 then b is ending a.
-                // In the previous case x=a^b=1010000 and x&-x=10000
-                constexpr U _id_ = fastcast::_fcast_id_<fcast<T, U>, V>::id;
-                const fcast_id_t x = w->fcast<T, U>::_fcast_id ^ _id_;
+                return _id_of<V>(_is_plugin<V>());
+            }
 
-                return std::is_base_of<V, W>::value || !x || (_id_ < (x & ((~x) + 1)));
+        // the id is a constant (so no call is emitted for it, even without optimization)
+        template<typename V>
+        inline static word_type _id_of(std::false_type) noexcept
+            {
+                constexpr word_type _id_ = id<V>();
+                return _id_;
             }
 
-        /**
-         * @return true if w is an instance of V
-         */
-        template<typename V, typename W>
-        inline static bool instanceof(W & w) noexcept
+        template<typename V>
+        inline static word_type _id_of(std::true_type)
             {
-                return instanceof<V, W>(&w);
+                typedef typename plugin<V>::parent parent;
+
+                static_assert(fastcast::number_of_bits(fastcast::_fcast_id_<fcast<T, U>, parent>::id) + fastcast::number_of_bits(plugin<V>::children::size - 1) + 1 <= 8 * sizeof(id_type), "The id of this plugin class does not fit in the id type of fcast (have a look at fastcast::id_type)");
+                return static_cast<word_type>(plugin<V>::template id<fcast<T, U>>());
             }
 
         /**
-         * @return true if the underlying type of w is V
+         * Set the _fcast_id field
          */
-        template<typename V, typename W>
-        inline static bool same(W * w) noexcept
+        template<typename V>
+        inline void set_id() noexcept(!_is_plugin<V>::value)
             {
-                return fastcast::_fcast_id_<fcast<T, U>, V>::id == w->fcast<T, U>::_fcast_id;
+                _fcast_id = static_cast<id_type>(_id_of<V>(_is_plugin<V>()));
             }
 
         /**
-         * @return true if the underlying type of w is V
+         * @return true if w is an instance of V
          */
         template<typename V, typename W>
-        inline static bool same(W & w) noexcept
+        inline static bool instanceof(W * w) noexcept(!_is_plugin<V>::value)
             {
-                return same<V, W>(&w);
+#if defined(FASTCAST_PROFILE)
+                return profile::scope<profile::op::instanceof, W, V>(w->fcast<T, U>::_fcast_id)(_instanceof<V>(w));
+#else
+                return _instanceof<V>(w);
+#endif
+            }
+
+        template<typename V, typename W>
+        inline static bool _instanceof(W * w) noexcept(!_is_plugin<V>::value)
+            {
+                // The cheapest test is chosen at compile time: true when W derives from V,
+                // an equality when V has no child, else a mask and a comparison
+                return std::is_base_of<V, W>::value || _ends_with<V>(static_cast<word_type>(w->fcast<T, U>::_fcast_id), _id_test<V>());
+            }
+
+        template<typename V>
+        inline static bool _ends_with(word_type fcast_id, std::integral_constant<int, 2>)
+            {
+                // a plugin class has no child and its id is given at runtime
+                return fcast_id == _id_of<V>(std::true_type());
+            }
+
+        template<typename V>
+        inline static bool _ends_with(word_type fcast_id, std::integral_constant<int, 1>) noexcept
+            {
+                // no class derives from V in the hierarchy so only V has its id
+                constexpr word_type _id_ = id<V>();
+                return fcast_id == _id_;
+            }
+
+        template<typename V>
+        inline static bool _ends_with(word_type fcast_id, std::integral_constant<int, 0>) noexcept
+            {
+                // Check if V::fcast_id ended w->fcast::_fcast_id in binary representation:
+                // the bits of fcast_id under the mask of V's id are V's id.
+                // For example, if a=1011011 and b=1011 then b is ending a.
+                constexpr word_type _id_ = id<V>();
+                constexpr word_type _mask_ = static_cast<word_type>(fastcast::id_mask(_id_));
+
+                return (fcast_id & _mask_) == _id_;
+            }
+
+        /**
+         * @return true if w is an instance of V
+         */
+        template<typename V, typename W>
+        inline static bool instanceof(W & w) noexcept(!_is_plugin<V>::value)
+            {
+                return instanceof<V, W>(&w);
+            }
+
+        /**
+         * @return true if the underlying type of w is V
+         */
+        template<typename V, typename W>
+        inline static bool same(W * w) noexcept(!_is_plugin<V>::value)
+            {
+#if defined(FASTCAST_PROFILE)
+                return profile::scope<profile::op::same, W, V>(w->fcast<T, U>::_fcast_id)(id_of<V>() == w->fcast<T, U>::_fcast_id);
+#else
+                return id_of<V>() == w->fcast<T, U>::_fcast_id;
+#endif
+            }
+
+        /**
+         * @return true if the underlying type of w is V
+         */
+        template<typename V, typename W>
+        inline static bool same(W & w) noexcept(!_is_plugin<V>::value)
+            {
+                return same<V, W>(&w);
             }
 
         /**
@@ -337,18 +911,22 @@ namespace fastcast
          * @return the casted pointer or nullptr if V is not an instance of U
          */
         template<typename V, typename W>
-        inline static V * cast(W * w) noexcept
+        inline static V * cast(W * w) noexcept(!_is_plugin<V>::value)
             {
-                return instanceof<V>(w) ? static_cast<V *>(w) : nullptr;
+#if defined(FASTCAST_PROFILE)
+                return profile::scope<profile::op::cast, W, V>(w->fcast<T, U>::_fcast_id)(_instanceof<V>(w)) ? _downcast<V>(w, _static_downcast<W, V>()) : nullptr;
+#else
+                return _instanceof<V>(w) ? _downcast<V>(w, _static_downcast<W, V>()) : nullptr;
+#endif
             }
 
         /**
-         * Just an alias for static_cast
+         * Just an alias for static_cast (or a lookup in the offset table when W is a virtual base of V)
          */
         template<typename V, typename W>
         inline static V & cast_unchecked(W * w)
             {
-                return static_cast<V *>(w);
+                return _downcast<V>(w, _static_downcast<W, V>());
             }
 
         /**
@@ -358,19 +936,1265 @@ namespace fastcast
         template<typename V, typename W>
         inline static V & cast(W & w)
             {
-                return instanceof<V>(w) ? static_cast<V &>(w) : throw fastcast::bad_cast();
+#if defined(FASTCAST_PROFILE)
+                return profile::scope<profile::op::cast, W, V>(w.fcast<T, U>::_fcast_id)(_instanceof<V>(&w)) ? *_downcast<V>(&w, _static_downcast<W, V>()) : throw fastcast::bad_cast();
+#else
+                return _instanceof<V>(&w) ? *_downcast<V>(&w, _static_downcast<W, V>()) : throw fastcast::bad_cast();
+#endif
             }
 
         /**
-         * Just an alias for static_cast
+         * Just an alias for static_cast (or a lookup in the offset table when W is a virtual base of V)
          */
         template<typename V, typename W>
         inline static V & cast_unchecked(W & w)
             {
-                return static_cast<V &>(w);
+                return *_downcast<V>(&w, _static_downcast<W, V>());
+            }
+
+        template<typename V, typename W>
+        inline static V * _downcast(W * w, std::true_type) noexcept
+            {
+                return static_cast<V *>(w);
+            }
+
+        template<typename V, typename W>
+        inline static V * _downcast(W * w, std::false_type) noexcept
+            {
+                // W is a virtual base of V: the offset depends on the exact class of w
+                static_assert(std::is_polymorphic<T>::value, "A cast through a virtual base needs a polymorphic root");
+                return _cross_cast<V>(w, std::false_type());
+            }
+
+        /**
+         * Check if the n pointers starting at first are instances of V
+         * The pointers must not be null.
+         * The bit i % 64 of mask[i / 64] is set when first[i] is an instance of V,
+         * so mask must have room for (n + 63) / 64 words.
+         * @return the number of instances of V
+         */
+        template<typename V, typename W>
+        static std::size_t instanceof_n(W * const * first, std::size_t n, uint64_t * mask) noexcept
+            {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < n; i += 64)
+                {
+                    const std::size_t m = n - i < 64 ? n - i : 64;
+                    const uint64_t bits = _instanceof_block<V>(first + i, m);
+                    mask[i / 64] = bits;
+                    count += fastcast::popcount(bits);
+                }
+
+                return count;
+            }
+
+        /**
+         * Copy the instances of V among the n pointers starting at first into out (order is preserved)
+         * The pointers must not be null and out must have room for n pointers.
+         * @return the number of pointers written in out
+         */
+        template<typename V, typename W>
+        static std::size_t filter(W * const * first, std::size_t n, V ** out) noexcept
+            {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < n; i += 64)
+                {
+                    const std::size_t m = n - i < 64 ? n - i : 64;
+                    for (uint64_t bits = _instanceof_block<V>(first + i, m); bits; bits &= bits - 1)
+                    {
+                        out[count++] = _downcast<V>(first[i + fastcast::lowest_bit(bits)], _static_downcast<W, V>());
+                    }
+                }
+
+                return count;
+            }
+
+        /**
+         * Split the n pointers starting at first: the instances of V are copied into in and the others into out
+         * (order is preserved in both outputs).
+         * The pointers must not be null and in and out must have room for n pointers.
+         * @return the number of pointers written in in
+         */
+        template<typename V, typename W>
+        static std::size_t partition(W * const * first, std::size_t n, V ** in, W ** out) noexcept
+            {
+                std::size_t count_in = 0;
+                std::size_t count_out = 0;
+                for (std::size_t i = 0; i < n; i += 64)
+                {
+                    const std::size_t m = n - i < 64 ? n - i : 64;
+                    const uint64_t bits = _instanceof_block<V>(first + i, m);
+                    for (uint64_t b = bits; b; b &= b - 1)
+                    {
+                        in[count_in++] = _downcast<V>(first[i + fastcast::lowest_bit(b)], _static_downcast<W, V>());
+                    }
+                    for (uint64_t b = ~bits & (m == 64 ? ~uint64_t(0) : ((uint64_t(1) << m) - 1)); b; b &= b - 1)
+                    {
+                        out[count_out++] = first[i + fastcast::lowest_bit(b)];
+                    }
+                }
+
+                return count_in;
+            }
+
+        /**
+         * Check at most 64 pointers
+         * @return a mask where the bit i is set when first[i] is an instance of V
+         */
+        template<typename V, typename W>
+        static uint64_t _instanceof_block(W * const * first, std::size_t n) noexcept
+            {
+                // The id of V ends the id of w iff the bits of w's id under V's mask are V's id
+                static_assert(!_is_plugin<V>::value, "The batch functions cannot test a plugin class");
+
+                constexpr word_type _id_ = id<V>();
+                constexpr word_type _mask_ = static_cast<word_type>(fastcast::id_mask(_id_));
+
+                if (std::is_base_of<V, W>::value)
+                {
+                    return n == 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1);
+                }
+
+                uint64_t bits = 0;
+                std::size_t i = 0;
+
+#if !defined(FASTCAST_NO_SIMD) && (defined(__AVX512F__) || defined(__AVX2__))
+                // Gather the low 32 bits of the ids (x86 is little endian), it is enough when V's id fits.
+                // The offset of the id in the objects must be the same for all of them (no virtual base between W and fcast).
+                if (sizeof(U) >= 4 && _mask_ <= 0xFFFFFFFFu && n >= 8 && _static_downcast<fcast<T, U>, W>::value)
+                {
+                    const std::ptrdiff_t offset = reinterpret_cast<const volatile char *>(&(first[0]->fcast<T, U>::_fcast_id)) - reinterpret_cast<const volatile char *>(first[0]);
+# if defined(__AVX512F__)
+                    const __m512i off = _mm512_set1_epi64(offset);
+                    const __m256i vmask = _mm256_set1_epi32(static_cast<int>(_mask_));
+                    const __m256i vid = _mm256_set1_epi32(static_cast<int>(_id_));
+                    for (; i + 16 <= n; i += 16)
+                    {
+                        const __m512i lo = _mm512_add_epi64(_mm512_loadu_si512(first + i), off);
+                        const __m512i hi = _mm512_add_epi64(_mm512_loadu_si512(first + i + 8), off);
+                        const __m256i ids_lo = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xFF, lo, nullptr, 1);
+                        const __m256i ids_hi = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xFF, hi, nullptr, 1);
+                        const __m256i eq_lo = _mm256_cmpeq_epi32(_mm256_and_si256(ids_lo, vmask), vid);
+                        const __m256i eq_hi = _mm256_cmpeq_epi32(_mm256_and_si256(ids_hi, vmask), vid);
+                        bits |= static_cast<uint64_t>(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(eq_lo)))
+                                                      | (static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(eq_hi))) << 8)) << i;
+                    }
+# else
+                    const __m256i off = _mm256_set1_epi64x(offset);
+                    const __m256i vmask = _mm256_set1_epi32(static_cast<int>(_mask_));
+                    const __m256i vid = _mm256_set1_epi32(static_cast<int>(_id_));
+                    for (; i + 8 <= n; i += 8)
+                    {
+                        const __m256i lo = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i)), off);
+                        const __m256i hi = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i + 4)), off);
+                        const __m256i ids = _mm256_set_m128i(_mm256_i64gather_epi32(static_cast<const int *>(nullptr), hi, 1), _mm256_i64gather_epi32(static_cast<const int *>(nullptr), lo, 1));
+                        const __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(ids, vmask), vid);
+                        bits |= static_cast<uint64_t>(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)))) << i;
+                    }
+# endif
+                }
+#elif !defined(FASTCAST_NO_SIMD) && defined(__SSE2__)
+                // No gather: the ids are loaded one by one and compared four by four
+                if (_mask_ <= 0xFFFFFFFFu)
+                {
+                    const __m128i vmask = _mm_set1_epi32(static_cast<int>(_mask_));
+                    const __m128i vid = _mm_set1_epi32(static_cast<int>(_id_));
+                    for (; i + 4 <= n; i += 4)
+                    {
+                        const __m128i ids = _mm_set_epi32(static_cast<int>(first[i + 3]->fcast<T, U>::_fcast_id),
+                                                          static_cast<int>(first[i + 2]->fcast<T, U>::_fcast_id),
+                                                          static_cast<int>(first[i + 1]->fcast<T, U>::_fcast_id),
+                                                          static_cast<int>(first[i]->fcast<T, U>::_fcast_id));
+                        const __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(ids, vmask), vid);
+                        bits |= static_cast<uint64_t>(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(eq)))) << i;
+                    }
+                }
+#endif
+
+                // Portable version (and tail of the vectorized ones)
+                for (; i < n; ++i)
+                {
+                    bits |= static_cast<uint64_t>((static_cast<word_type>(first[i]->fcast<T, U>::_fcast_id) & _mask_) == _id_) << i;
+                }
+
+                return bits;
+            }
+    };
+
+    // Get the fcast base of the root class Root: fcast_of<Root>::type is fcast<Root, U>
+    template<typename T, typename U>
+    fcast<T, U> _fcast_base_(const volatile fcast<T, U> *);
+
+    template<typename Root>
+    struct fcast_of
+    {
+        typedef decltype(_fcast_base_<Root>(static_cast<Root *>(nullptr))) type;
+    };
+
+    // The list of the children given in a hierarchy definition
+    template<typename C>
+    struct _children_list
+    {
+        typedef type_list<> type;
+    };
+
+    template<typename... C>
+    struct _children_list<children<C...>>
+    {
+        typedef type_list<typename _unweight<C>::type...> type;
+    };
+
+    template<typename V>
+    struct _is_leaf : std::integral_constant<bool, _children_list<typename V::fcast_hierarchy::children>::type::size == 0>
+    {
+    };
+
+    template<typename V>
+    struct _id_test : std::integral_constant<int, _is_plugin<V>::value ? 2 : _is_leaf<V>::value ? 1 : 0>
+    {
+    };
+
+    template<typename Root, typename Me, typename L>
+    struct _subtrees;
+
+    // The classes of the tree of Root starting at Me in prefix order (so a subtree is a contiguous range)
+    template<typename Root, typename Me>
+    struct _subtree
+    {
+        typedef typename _concat<type_list<Me>, typename _subtrees<Root, Me, typename _children_list<typename Me::fcast_hierarchy::children>::type>::type>::type type;
+    };
+
+    // The subtrees of a child: a child which is not in Root's tree (cross casts) is skipped
+    // and a child without its own fcast_hierarchy is a leaf
+    template<typename Root, typename Me, typename C, bool = std::is_base_of<Root, C>::value, bool = std::is_same<typename Me::fcast_hierarchy, typename C::fcast_hierarchy>::value>
+    struct _child_subtree
+    {
+        typedef type_list<> type;
+    };
+
+    template<typename Root, typename Me, typename C>
+    struct _child_subtree<Root, Me, C, true, false>
+    {
+        typedef typename _subtree<Root, C>::type type;
+    };
+
+    template<typename Root, typename Me, typename C>
+    struct _child_subtree<Root, Me, C, true, true>
+    {
+        typedef type_list<C> type;
+    };
+
+    template<typename Root, typename Me>
+    struct _subtrees<Root, Me, type_list<>>
+    {
+        typedef type_list<> type;
+    };
+
+    template<typename Root, typename Me, typename C, typename... Cs>
+    struct _subtrees<Root, Me, type_list<C, Cs...>>
+    {
+        typedef typename _concat<typename _child_subtree<Root, Me, C>::type, typename _subtrees<Root, Me, type_list<Cs...>>::type>::type type;
+    };
+
+    // The slots reserved for the plugin classes are not classes (and the plugin classes are not in the list)
+    template<typename Root, typename Me, unsigned int N, typename... Cs>
+    struct _subtrees<Root, Me, type_list<slots<N>, Cs...>>
+    {
+        typedef typename _subtrees<Root, Me, type_list<Cs...>>::type type;
+    };
+
+    // All the classes of the hierarchy of the root class Root in prefix order
+    template<typename Root>
+    struct hierarchy_of
+    {
+        typedef typename _subtree<Root, Root>::type type;
+    };
+
+    // L with R appended if it isn't already in L
+    template<typename L, typename R, bool = (_position<R, L>::value < L::size)>
+    struct _append_unique
+    {
+        typedef L type;
+    };
+
+    template<typename... L, typename R>
+    struct _append_unique<type_list<L...>, R, false>
+    {
+        typedef type_list<L..., R> type;
+    };
+
+    template<typename L, typename... R>
+    struct _merge_unique
+    {
+        typedef L type;
+    };
+
+    template<typename L, typename R, typename... Rs>
+    struct _merge_unique<L, type_list<R, Rs...>>
+    {
+        typedef typename _merge_unique<typename _append_unique<L, R>::type, type_list<Rs...>>::type type;
+    };
+
+    template<typename L, typename R1, typename R2, typename... Rs>
+    struct _merge_unique<L, R1, R2, Rs...>
+    {
+        typedef typename _merge_unique<typename _merge_unique<L, R1>::type, R2, Rs...>::type type;
+    };
+
+    // The root classes of V (one for each fcast base of V)
+    template<typename V, typename P = typename V::fcast_hierarchy::parent>
+    struct _roots
+    {
+        typedef typename _roots<P>::type type;
+    };
+
+    template<typename V>
+    struct _roots<V, root>
+    {
+        typedef type_list<V> type;
+    };
+
+    template<typename V, typename... P>
+    struct _roots<V, parents<P...>>
+    {
+        typedef typename _merge_unique<type_list<>, typename _roots<P>::type...>::type type;
+    };
+
+    // true when Root derives from a fastcast::fcast
+    template<typename Root, typename = void>
+    struct _has_fcast : std::false_type { };
+
+    template<typename Root>
+    struct _has_fcast<Root, decltype(void(_fcast_base_<Root>(static_cast<Root *>(nullptr))))> : std::true_type { };
+
+    // true when V is Root, a plugin class or a child of its parent in the tree of Root
+    // (a class which is not in the children of its parent would get the id computed for another class)
+    template<typename Root, typename V>
+    struct _registered : std::integral_constant<bool, std::is_same<Root, V>::value || _is_plugin<V>::value
+                                                     || _position<V, typename _children_list<typename _get_parent<Root, typename V::fcast_hierarchy::parent>::type::fcast_hierarchy::children>::type>::value
+                                                     < _children_list<typename _get_parent<Root, typename V::fcast_hierarchy::parent>::type::fcast_hierarchy::children>::type::size>
+    {
+    };
+
+    template<typename V, typename Root>
+    inline void _set_root_id(V & v, std::true_type) noexcept(!_is_plugin<V>::value)
+    {
+        static_assert(_registered<Root, V>::value, "This class is not registered in the hierarchy (it has no fcast_hierarchy or is not in the children of its parent)");
+        static_cast<typename fcast_of<Root>::type &>(v).template set_id<V>();
+    }
+
+    template<typename V, typename Root>
+    inline void _set_root_id(V &, std::false_type) noexcept { }
+
+    template<typename V, typename... Roots>
+    inline void _set_ids(V & v, type_list<Roots...>) noexcept(!_is_plugin<V>::value)
+    {
+        const int dummy[] = { 0, (_set_root_id<V, Roots>(v, _has_fcast<Roots>()), 0)... };
+        (void)dummy;
+    }
+
+    /**
+     * Set the ids of v (one store for each root of V) where V is the dynamic type of v
+     * (a plugin class takes its slot on its first use: throw a fastcast::no_slot exception when there is none left)
+     */
+    template<typename V>
+    inline void set_ids(V & v) noexcept(!_is_plugin<V>::value)
+    {
+        _set_ids(v, typename _roots<V>::type());
+    }
+
+    // A plugin class takes its slot before it is built, so setting its ids cannot throw once it is built
+    template<typename V>
+    inline void _reserve_slot(std::true_type)
+    {
+        plugin<V>::reserve();
+    }
+
+    template<typename V>
+    inline void _reserve_slot(std::false_type) noexcept { }
+
+    /**
+     * Wrapper which sets the ids of a V once V is constructed: the constructors of the hierarchy
+     * don't need to call set_id
+     */
+    template<typename V>
+    struct concrete final : public V
+    {
+        template<typename... Args>
+        explicit concrete(Args &&... args) : V(std::forward<Args>(args)...)
+            {
+                set_ids<V>(*this);
+            }
+    };
+
+    /**
+     * @return a new V where the ids are set once V is constructed
+     * (throw a fastcast::no_slot exception before building a plugin class which has no slot left)
+     */
+    template<typename V, typename... Args>
+    inline V * make(Args &&... args)
+    {
+        _reserve_slot<V>(_is_plugin<V>());
+        V * v = new V(std::forward<Args>(args)...);
+        set_ids(*v);
+        return v;
+    }
+
+    /**
+     * Construct a V at where and set its ids
+     * @return the new V
+     */
+    template<typename V, typename... Args>
+    inline V * construct(void * where, Args &&... args)
+    {
+        _reserve_slot<V>(_is_plugin<V>());
+        V * v = new (where) V(std::forward<Args>(args)...);
+        set_ids(*v);
+        return v;
+    }
+
+    /**
+     * @return the greatest argument
+     */
+    constexpr _wide_id_t _max_id_(_wide_id_t a, _wide_id_t b) noexcept
+    {
+        return a > b ? a : b;
+    }
+
+    // A list of keys (followed by 0)
+    template<_wide_id_t... K>
+    struct _key_list
+    {
+        constexpr static _wide_id_t ids[sizeof...(K) + 1] = { K..., 0 };
+
+        /**
+         * @return the greatest key in ids[lo..hi[ (divide and conquer to keep a logarithmic depth)
+         */
+        constexpr static _wide_id_t max(std::size_t lo = 0, std::size_t hi = sizeof...(K) + 1) noexcept
+            {
+                return hi - lo == 1 ? ids[lo] : _max_id_(max(lo, lo + (hi - lo) / 2), max(lo + (hi - lo) / 2, hi));
             }
     };
 
+    template<_wide_id_t... K>
+    constexpr _wide_id_t _key_list<K...>::ids[sizeof...(K) + 1];
+
+    // The ids (for the root class or the fcast F) of the classes of a list (followed by 0)
+    template<typename F, typename L>
+    struct _id_list;
+
+    template<typename F, typename... C>
+    struct _id_list<F, type_list<C...>> : public _key_list<_fcast_id_<F, C>::id...>
+    {
+    };
+
+    // The number of bits of the longest id in the hierarchy of the root class Root
+    template<typename Root, typename L = typename hierarchy_of<Root>::type>
+    struct id_bits
+    {
+        constexpr static unsigned int value = number_of_bits(_id_list<Root, L>::max());
+    };
+
+    // The smallest unsigned integer type having at least Bits bits
+    template<unsigned int Bits>
+    struct uint_least
+    {
+        static_assert(Bits <= 8 * sizeof(_wide_id_t), "No integer type is wide enough");
+
+        typedef typename std::conditional<(Bits <= 8), uint8_t,
+                typename std::conditional<(Bits <= 16), uint16_t,
+                typename std::conditional<(Bits <= 32), uint32_t,
+                typename std::conditional<(Bits <= 64), uint64_t, _wide_id_t>::type>::type>::type>::type type;
+    };
+
+    // The smallest id type for the hierarchy of the root class Root, to be used in fcast<Root, U>
+    // For example, static_assert(std::is_same<fastcast::id_type<A>::type, Fcast::id_type>::value, "...")
+    // checks that the id type of A is the best one.
+    template<typename Root>
+    struct id_type
+    {
+        typedef typename uint_least<id_bits<Root>::value>::type type;
+    };
+
+    // The table mapping an id to a position: Index::find is evaluated at compile time for each id in I
+    template<typename Index, typename I>
+    struct _id_direct_table;
+
+    template<typename Index, std::size_t... I>
+    struct _id_direct_table<Index, _indices<I...>>
+    {
+        constexpr static typename Index::index_t table[sizeof...(I)] = { static_cast<typename Index::index_t>(Index::find(I, 0, Index::size))... };
+    };
+
+    template<typename Index, std::size_t... I>
+    constexpr typename Index::index_t _id_direct_table<Index, _indices<I...>>::table[sizeof...(I)];
+
+// Ids lower than 2^FASTCAST_DIRECT_INDEX_BITS are mapped to a position with a constant array, else a hash table is used
+#ifndef FASTCAST_DIRECT_INDEX_BITS
+# define FASTCAST_DIRECT_INDEX_BITS 12
+#endif
+
+    // Map each key K (of the type Word at runtime) to its position in K (0 is not a key)
+    // An unknown key is mapped to the number of keys
+    template<typename Word, _wide_id_t... K>
+    class _key_index
+    {
+    public:
+
+        typedef Word word_type;
+
+        typedef typename std::conditional<(sizeof...(K) < 0xFFFF), uint16_t, uint32_t>::type index_t;
+
+        constexpr static std::size_t size = sizeof...(K);
+        constexpr static _wide_id_t ids[sizeof...(K)] = { K... };
+        constexpr static _wide_id_t max = _key_list<K...>::max();
+        constexpr static bool direct = max < (_wide_id_t(1) << FASTCAST_DIRECT_INDEX_BITS);
+
+        /**
+         * @return the position of id in ids[lo..hi[ or size if not found
+         */
+        constexpr static std::size_t find(_wide_id_t id, std::size_t lo, std::size_t hi) noexcept
+            {
+                return hi - lo == 1 ? (ids[lo] == id && id ? lo : size) : _min_pos(find(id, lo, lo + (hi - lo) / 2), find(id, lo + (hi - lo) / 2, hi));
+            }
+
+        /**
+         * @return the position of the given key or size if it is not a key
+         */
+        inline static std::size_t get(word_type id) noexcept
+            {
+                return get(id, std::integral_constant<bool, direct>());
+            }
+
+    private:
+
+        typedef _id_direct_table<_key_index, typename _make_indices<direct ? max + 1 : 0>::type> direct_table;
+
+        // Open addressing with a load factor lower than 1/2
+        struct hash_table
+        {
+            std::vector<word_type> keys;
+            std::vector<index_t> values;
+            std::size_t mask;
+            unsigned int shift;
+
+            hash_table() : mask(0), shift(64)
+                {
+                    std::size_t n = 1;
+                    for (; n < 2 * size; n <<= 1)
+                    {
+                        --shift;
+                    }
+                    mask = n - 1;
+                    keys.assign(n, 0);
+                    values.assign(n, static_cast<index_t>(size));
+                    for (std::size_t i = 0; i < size; ++i)
+                    {
+                        const word_type id = static_cast<word_type>(ids[i]);
+                        std::size_t h = hash(id);
+                        for (; keys[h] && keys[h] != id; h = (h + 1) & mask) { }
+                        if (id && !keys[h])
+                        {
+                            keys[h] = id;
+                            values[h] = static_cast<index_t>(i);
+                        }
+                    }
+                }
+
+            inline std::size_t hash(word_type id) const noexcept
+                {
+                    // fold the ids wider than 64 bits
+                    const uint64_t x = static_cast<uint64_t>(id) ^ static_cast<uint64_t>((id >> 32) >> 32);
+                    return shift >= 64 ? 0 : static_cast<std::size_t>((x * 0x9E3779B97F4A7C15ull) >> shift);
+                }
+        };
+
+        inline static std::size_t get(word_type id, std::true_type) noexcept
+            {
+                return id <= max ? direct_table::table[id] : size;
+            }
+
+        inline static std::size_t get(word_type id, std::false_type) noexcept
+            {
+                static const hash_table table;
+                for (std::size_t h = table.hash(id);; h = (h + 1) & table.mask)
+                {
+                    if (table.keys[h] == id)
+                    {
+                        return table.values[h];
+                    }
+                    if (!table.keys[h])
+                    {
+                        return size;
+                    }
+                }
+            }
+    };
+
+    template<typename Word, _wide_id_t... K>
+    constexpr _wide_id_t _key_index<Word, K...>::ids[sizeof...(K)];
+
+    // Map the exact id (for the fcast F) of each class of the list L to its position in L
+    // An unknown id is mapped to the size of L
+    template<typename F, typename L>
+    class _id_index;
+
+    template<typename F, typename... C>
+    class _id_index<F, type_list<C...>> : public _key_index<typename F::word_type, _fcast_id_<F, C>::id...>
+    {
+    };
+
+    template<typename H, typename...>
+    struct _first
+    {
+        typedef H type;
+    };
+
+    // The argument and result types of a callable (argument is the type of the first argument)
+    template<typename H>
+    struct _callable : _callable<decltype(&H::operator())>
+    {
+    };
+
+    template<typename R, typename... Args>
+    struct _callable<R (*)(Args...)>
+    {
+        typedef R result;
+        typedef type_list<typename std::decay<Args>::type...> arguments;
+        typedef typename _first<typename std::decay<Args>::type..., void>::type argument;
+    };
+
+    template<typename R, typename... Args>
+    struct _callable<R (&)(Args...)> : _callable<R (*)(Args...)>
+    {
+    };
+
+    template<typename H, typename R, typename... Args>
+    struct _callable<R (H::*)(Args...)> : _callable<R (*)(Args...)>
+    {
+    };
+
+    template<typename H, typename R, typename... Args>
+    struct _callable<R (H::*)(Args...) const> : _callable<R (*)(Args...)>
+    {
+    };
+
+    // The position of the most specific class in A... which is Me or one of its bases (-1 if none)
+    template<typename Me, int I, int Best, typename BestT, typename... A>
+    struct _best_arm
+    {
+        constexpr static int value = Best;
+    };
+
+    template<typename Me, int I, int Best, typename BestT, typename A0, typename... A>
+    struct _best_arm<Me, I, Best, BestT, A0, A...>
+    {
+        constexpr static bool better = std::is_base_of<A0, Me>::value && (Best < 0 || (std::is_base_of<BestT, A0>::value && !std::is_same<BestT, A0>::value));
+        constexpr static int value = _best_arm<Me, I + 1, better ? I : Best, typename std::conditional<better, A0, BestT>::type, A...>::value;
+    };
+
+    // Call the I-th handler of the tuple
+    template<typename R, typename W, typename Tuple, int I, typename... A>
+    struct _match_arm
+    {
+        typedef typename std::tuple_element<I, std::tuple<A...>>::type arg;
+        typedef typename std::conditional<std::is_const<W>::value, const arg, arg>::type & ref;
+
+        inline static R call(W & w, Tuple & handlers)
+            {
+                return std::get<I>(handlers)(static_cast<ref>(w));
+            }
+    };
+
+    // No handler: a default value is returned
+    template<typename R, typename W, typename Tuple, typename... A>
+    struct _match_arm<R, W, Tuple, -1, A...>
+    {
+        inline static R call(W &, Tuple &)
+            {
+                return R();
+            }
+    };
+
+    // Is the I-th handler callable with a W (i.e. its argument is a base or a derived class of W)
+    template<typename W, bool Valid, std::size_t I, typename... A>
+    struct _match_callable
+    {
+        typedef typename std::tuple_element<I, std::tuple<A...>>::type arg;
+
+        constexpr static bool value = std::is_base_of<arg, W>::value || std::is_base_of<W, arg>::value;
+    };
+
+    template<typename W, std::size_t I, typename... A>
+    struct _match_callable<W, false, I, A...>
+    {
+        constexpr static bool value = false;
+    };
+
+    // Call the k-th handler with k in [Lo, Hi[ (k == sizeof...(A) means no handler)
+    // The handlers are called directly (not with a pointer) so they can be inlined and the comparisons become a switch
+    template<typename R, typename W, typename Tuple, std::size_t Lo, std::size_t Hi, typename... A>
+    struct _match_dispatch
+    {
+        inline static R call(std::size_t k, W & w, Tuple & handlers)
+            {
+                return k == Lo ? _match_dispatch<R, W, Tuple, Lo, Lo + 1, A...>::call(k, w, handlers) : _match_dispatch<R, W, Tuple, Lo + 1, Hi, A...>::call(k, w, handlers);
+            }
+    };
+
+    template<typename R, typename W, typename Tuple, std::size_t Lo, typename... A>
+    struct _match_dispatch<R, W, Tuple, Lo, Lo + 1, A...>
+    {
+        inline static R call(std::size_t, W & w, Tuple & handlers)
+            {
+                // the handlers which cannot be called with a W are unreachable
+                return _match_arm<R, W, Tuple, (_match_callable<typename std::remove_cv<W>::type, (Lo < sizeof...(A)), Lo, A...>::value ? static_cast<int>(Lo) : -1), A...>::call(w, handlers);
+            }
+    };
+
+    // The handler to call for each class of the list L (by position in L), the last entry is for an unknown id
+    // When the ids are small, the handler is directly given by a table indexed by the id
+    template<typename F, typename W, typename L, typename... A>
+    class _match_table;
+
+    template<typename F, typename W, typename... C, typename... A>
+    class _match_table<F, W, type_list<C...>, A...>
+    {
+        typedef _id_index<F, type_list<C...>> ids;
+
+    public:
+
+        typedef typename std::conditional<(sizeof...(A) < 0xFF), uint8_t, uint16_t>::type index_t;
+
+        constexpr static std::size_t size = sizeof...(A);
+
+        // the classes which are not derived from W are unreachable
+        constexpr static index_t table[sizeof...(C) + 1] = { static_cast<index_t>(std::is_base_of<typename std::remove_cv<W>::type, C>::value && _best_arm<C, 0, -1, void, A...>::value >= 0 ? _best_arm<C, 0, -1, void, A...>::value : sizeof...(A))..., static_cast<index_t>(sizeof...(A)) };
+
+        /**
+         * @return the handler for the id (evaluated at compile time for the direct table)
+         */
+        constexpr static std::size_t find(_wide_id_t id, std::size_t, std::size_t) noexcept
+            {
+                return table[ids::find(id, 0, ids::size)];
+            }
+
+        /**
+         * @return the position of the handler to call for the given id or the number of handlers if there is none
+         */
+        inline static std::size_t get(typename F::word_type id) noexcept
+            {
+                return get(id, std::integral_constant<bool, ids::direct>());
+            }
+
+    private:
+
+        typedef _id_direct_table<_match_table, typename _make_indices<ids::direct ? ids::max + 1 : 0>::type> direct_table;
+
+        inline static std::size_t get(typename F::word_type id, std::true_type) noexcept
+            {
+                return id <= ids::max ? direct_table::table[id] : size;
+            }
+
+        inline static std::size_t get(typename F::word_type id, std::false_type) noexcept
+            {
+                return table[ids::get(id)];
+            }
+    };
+
+    template<typename F, typename W, typename... C, typename... A>
+    constexpr typename _match_table<F, W, type_list<C...>, A...>::index_t _match_table<F, W, type_list<C...>, A...>::table[sizeof...(C) + 1];
+
+    /**
+     * Type switch: call the handler taking the most derived class which is the dynamic class of the object or one of its bases
+     * For example, with the handlers [](B & b) { ... } and [](D & d) { ... }, the second one is called when the object
+     * is a D or a E and the first one when it is a B or a C.
+     * The handlers are looked up in a table indexed by the exact id of the object, so the cost does not depend on their number
+     * (but on a small hierarchy, a chain of casts is a bit faster since its branches are better predicted than the jump).
+     * When there is no handler for the object, a default value is returned.
+     */
+    template<typename Root, typename... H>
+    class matcher
+    {
+        typedef typename fcast_of<Root>::type F;
+        typedef typename hierarchy_of<Root>::type L;
+        typedef std::tuple<H...> Tuple;
+
+        Tuple handlers;
+
+    public:
+
+        typedef typename _callable<typename std::decay<typename _first<H...>::type>::type>::result result_type;
+
+        matcher(H... h) : handlers(std::forward<H>(h)...) { }
+
+        template<typename W>
+        inline result_type operator()(W & w)
+            {
+                typedef _match_table<F, W, L, typename _callable<typename std::decay<H>::type>::argument...> Table;
+
+                static_assert(std::is_base_of<Root, typename std::remove_cv<W>::type>::value, "The matched object must be in the hierarchy of Root");
+
+                const std::size_t k = Table::get(static_cast<const F &>(w)._fcast_id);
+                return _match_dispatch<result_type, W, Tuple, 0, sizeof...(H) + 1, typename _callable<typename std::decay<H>::type>::argument...>::call(k, w, handlers);
+            }
+
+        /**
+         * w must not be null
+         */
+        template<typename W>
+        inline result_type operator()(W * w)
+            {
+                return (*this)(*w);
+            }
+    };
+
+    /**
+     * @return a matcher holding a copy of the handlers (to be reused in a loop)
+     */
+    template<typename Root, typename... H>
+    inline matcher<Root, typename std::decay<H>::type...> make_matcher(H &&... handlers)
+    {
+        return matcher<Root, typename std::decay<H>::type...>(std::forward<H>(handlers)...);
+    }
+
+    /**
+     * Type switch on w (see matcher)
+     * For example, match<A>(a, [](B & b) { ... }, [](D & d) { ... }).
+     * @return the value returned by the handler or a default value when no handler applies
+     */
+    template<typename Root, typename W, typename... H>
+    inline typename _callable<typename std::decay<typename _first<H...>::type>::type>::result match(W & w, H &&... handlers)
+    {
+        return matcher<Root, typename std::remove_reference<H>::type &...>(handlers...)(w);
+    }
+
+    /**
+     * Type switch on w (w must not be null)
+     */
+    template<typename Root, typename W, typename... H>
+    inline typename _callable<typename std::decay<typename _first<H...>::type>::type>::result match(W * w, H &&... handlers)
+    {
+        return match<Root>(*w, std::forward<H>(handlers)...);
+    }
+
+    template<typename L>
+    struct _head;
+
+    template<typename U, typename... C>
+    struct _head<type_list<U, C...>>
+    {
+        typedef U type;
+    };
+
+    // For each class of the hierarchy of Root (plus an unknown class), the offset to add to a pointer on the Root
+    // subobject to get a pointer on the To subobject (none when the class doesn't derive from To).
+    // When Root or To is a virtual base of the class, the offset is only known from an object: it is computed
+    // the first time an object of this class is casted (lazy) and the next casts only read it.
+    template<typename Root, typename To, typename L = typename hierarchy_of<Root>::type>
+    struct _cross_table;
+
+    template<typename Root, typename To, typename... C>
+    struct _cross_table<Root, To, type_list<C...>>
+    {
+        constexpr static std::ptrdiff_t none = PTRDIFF_MIN;
+        constexpr static std::ptrdiff_t lazy = PTRDIFF_MIN + 1;
+
+        // true when X is a Root and a To but the offset between them depends on the virtual bases of X
+        template<typename X>
+        struct through_virtual : std::integral_constant<bool, !(_static_downcast<Root, X>::value && _static_downcast<To, X>::value) && std::is_convertible<X *, Root *>::value && std::is_convertible<X *, To *>::value>
+        {
+        };
+
+        static_assert(std::is_polymorphic<Root>::value || _first_true<through_virtual<C>::value...>::find(0, sizeof...(C) + 1) == sizeof...(C), "A cast through a virtual base needs a polymorphic root");
+
+        // 2 when the offset is a constant, 1 when it depends on the virtual bases of X, 0 when X is not a To
+        template<typename X>
+        struct path : std::integral_constant<int, _static_downcast<Root, X>::value && _static_downcast<To, X>::value ? 2 : (through_virtual<X>::value ? 1 : 0)>
+        {
+        };
+
+        template<typename X>
+        static std::ptrdiff_t offset(std::integral_constant<int, 2>) noexcept
+            {
+                // the conversions between non-virtual bases only add a constant so a fake (aligned) address is enough
+                X * const x = reinterpret_cast<X *>(static_cast<std::uintptr_t>(alignof(X)) << 12);
+                return reinterpret_cast<char *>(static_cast<To *>(x)) - reinterpret_cast<char *>(static_cast<Root *>(x));
+            }
+
+        template<typename X>
+        static std::ptrdiff_t offset(std::integral_constant<int, 1>) noexcept
+            {
+                return lazy;
+            }
+
+        template<typename X>
+        static std::ptrdiff_t offset(std::integral_constant<int, 0>) noexcept
+            {
+                return none;
+            }
+
+        // r is the Root subobject of a complete X: its address is found with dynamic_cast<void *>
+        // (it only reads the offset to the top in the virtual table)
+        template<typename X>
+        static std::ptrdiff_t compute(Root * r, std::true_type) noexcept
+            {
+                To * const t = static_cast<X *>(dynamic_cast<void *>(r));
+                return reinterpret_cast<char *>(t) - reinterpret_cast<char *>(r);
+            }
+
+        template<typename X>
+        static std::ptrdiff_t compute(Root *, std::false_type) noexcept
+            {
+                return none;
+            }
+
+        inline static std::atomic<std::ptrdiff_t> * get() noexcept
+            {
+                static std::atomic<std::ptrdiff_t> table[sizeof...(C) + 1] = { { offset<C>(path<C>()) }..., { none } };
+                return table;
+            }
+
+        /**
+         * @return the offset for the i-th class (r is an instance of this class), computed if it is lazy
+         */
+        inline static std::ptrdiff_t resolve(std::size_t i, Root * r) noexcept
+            {
+                typedef std::ptrdiff_t (*function)(Root *);
+                static const function functions[sizeof...(C) + 1] = { &compute<C>..., &compute<void> };
+
+                std::atomic<std::ptrdiff_t> & entry = get()[i];
+                std::ptrdiff_t offset = entry.load(std::memory_order_relaxed);
+                if (offset == lazy)
+                {
+                    // several threads can compute it, they store the same value
+                    offset = functions[i](r);
+                    entry.store(offset, std::memory_order_relaxed);
+                }
+
+                return offset;
+            }
+
+    private:
+
+        template<typename X>
+        static std::ptrdiff_t compute(Root * r) noexcept
+            {
+                return compute<X>(r, std::integral_constant<bool, path<X>::value == 1>());
+            }
+    };
+
+    template<typename Root, typename To, typename... C>
+    constexpr std::ptrdiff_t _cross_table<Root, To, type_list<C...>>::none;
+
+    template<typename Root, typename To, typename... C>
+    constexpr std::ptrdiff_t _cross_table<Root, To, type_list<C...>>::lazy;
+
+    template<typename To, typename W>
+    inline To * _cross_cast(W * w, std::true_type) noexcept
+    {
+        return w;
+    }
+
+    template<typename To, typename W>
+    inline To * _cross_cast(W * w, std::false_type) noexcept
+    {
+        typedef typename _head<typename _roots<W>::type>::type Root;
+        typedef typename fcast_of<Root>::type F;
+        typedef _cross_table<Root, To> Table;
+
+        if (w)
+        {
+            Root * r = w;
+            const std::size_t i = _id_index<F, typename hierarchy_of<Root>::type>::get(static_cast<const F *>(r)->_fcast_id);
+            std::ptrdiff_t offset = Table::get()[i].load(std::memory_order_relaxed);
+            if (offset == Table::lazy)
+            {
+                offset = Table::resolve(i, r);
+            }
+            if (offset != Table::none)
+            {
+                return reinterpret_cast<To *>(reinterpret_cast<char *>(r) + offset);
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * Cast w to a To in any direction, for example sideways from a A * to a D * when the dynamic type derives from both
+     * (have a look at fastcast::parents): the exact id of w gives the offset from its root to To in a table.
+     * The paths through a virtual base are supported when the root is polymorphic: the offset of each class is computed
+     * from the first object of this class which is casted, so the objects must be complete objects of the class given by their id.
+     * @return the casted pointer or nullptr if w is null or is not an instance of To
+     */
+    template<typename To, typename W>
+    inline To * cross_cast(W * w) noexcept
+    {
+        return _cross_cast<To>(w, std::is_convertible<W *, To *>());
+    }
+
+    /**
+     * Cast w to a To reference in any direction (see cross_cast(W *))
+     * @return the casted reference or throw a fastcast::bad_cast exception
+     */
+    template<typename To, typename W>
+    inline To & cross_cast(W & w)
+    {
+        To * const t = cross_cast<To>(&w);
+        return t ? *t : throw fastcast::bad_cast();
+    }
+
+    // The I-th type of a list: the list is indexed once, then each lookup is a template argument deduction
+    template<std::size_t I, typename T>
+    struct _indexed
+    {
+        typedef T type;
+    };
+
+    template<typename L, typename I = typename _make_indices<L::size>::type>
+    struct _indexed_list;
+
+    template<typename... C, std::size_t... I>
+    struct _indexed_list<type_list<C...>, _indices<I...>> : _indexed<I, C>...
+    {
+    };
+
+    template<std::size_t I, typename T>
+    _indexed<I, T> _select(const _indexed<I, T> *);
+
+    template<std::size_t I, typename L>
+    struct _type_at
+    {
+        typedef typename decltype(_select<I>(static_cast<const _indexed_list<L> *>(nullptr)))::type type;
+    };
+
+    // The root class, the fcast and the classes (in prefix order) of the hierarchy of W
+    template<typename W>
+    struct _dense
+    {
+        typedef typename _head<typename _roots<typename std::remove_cv<W>::type>::type>::type root;
+        typedef typename fcast_of<root>::type fcast;
+        typedef typename hierarchy_of<root>::type classes;
+
+        constexpr static std::size_t size = classes::size;
+
+        inline static std::size_t index(W & w) noexcept
+            {
+                return _id_index<fcast, classes>::get(static_cast<const fcast &>(w)._fcast_id);
+            }
+    };
+
+    // The number of classes in the hierarchy of the root class Root
+    template<typename Root>
+    struct dense_size : std::integral_constant<std::size_t, _dense<Root>::size>
+    {
+    };
+
+    // The dense index of V in the hierarchy of the root class Root: its position in hierarchy_of<Root>::type
+    template<typename Root, typename V>
+    struct dense_index_of : std::integral_constant<std::size_t, _position<V, typename hierarchy_of<Root>::type>::value>
+    {
+    };
+
+    /**
+     * @return the dense index of the dynamic class of w: a number in [0, dense_size<Root>::value[
+     * (dense_size<Root>::value when the class is unknown)
+     */
+    template<typename W>
+    inline std::size_t dense_index(W & w) noexcept
+    {
+        return _dense<W>::index(w);
+    }
+
+    /**
+     * @return the dense index of the dynamic class of w (w must not be null)
+     */
+    template<typename W>
+    inline std::size_t dense_index(W * w) noexcept
+    {
+        return _dense<W>::index(*w);
+    }
+
+    template<bool... B>
+    struct _all : std::integral_constant<bool, _first_true<!B...>::find(0, sizeof...(B) + 1) == sizeof...(B)>
+    {
+    };
+
+    // true when a handler taking A... can be called with the classes C...
+    template<typename A, typename C>
+    struct _applies;
+
+    template<typename... A, typename... C>
+    struct _applies<type_list<A...>, type_list<C...>> : _all<std::is_base_of<A, C>::value...>
+    {
+    };
+
+    // true when the handler taking A... is more specific than the one taking B...
+    template<typename A, typename B>
+    struct _more_specific;
+
+    template<typename A>
+    struct _more_specific<A, void> : std::true_type
+    {
+    };
+
+    template<typename... A, typename... B>
+    struct _more_specific<type_list<A...>, type_list<B...>> : std::integral_constant<bool, _all<std::is_base_of<B, A>::value...>::value && !_all<std::is_same<B, A>::value...>::value>
+    {
+    };
+
+    // The position of the most specific handler which can be called with the classes C (-1 if none)
+    template<typename C, int I, int Best, typename BestA, typename... A>
+    struct _best_method
+    {
+        constexpr static int value = Best;
+    };
+
+    template<typename C, int I, int Best, typename BestA, typename A0, typename... A>
+    struct _best_method<C, I, Best, BestA, A0, A...>
+    {
+        constexpr static bool better = _applies<A0, C>::value && _more_specific<A0, BestA>::value;
+        constexpr static int value = _best_method<C, I + 1, better ? I : Best, typename std::conditional<better, A0, BestA>::type, A...>::value;
+    };
+
+    // Call the I-th handler of the tuple with the arguments casted to A...
+    template<typename R, typename Tuple, typename W, int I, typename A>
+    struct _method_arm;
+
+    template<typename R, typename Tuple, typename... W, int I, typename... A>
+    struct _method_arm<R, Tuple, type_list<W...>, I, type_list<A...>>
+    {
+        static R call(Tuple & handlers, W &... w)
+            {
+                return std::get<I>(handlers)(static_cast<typename std::conditional<std::is_const<W>::value, const A, A>::type &>(w)...);
+            }
+    };
+
+    // No handler: a default value is returned
+    template<typename R, typename Tuple, typename... W, typename... A>
+    struct _method_arm<R, Tuple, type_list<W...>, -1, type_list<A...>>
+    {
+        static R call(Tuple &, W &...)
+            {
+                return R();
+            }
+    };
+
+    // The class at position I in the hierarchy of W, or void for the unknown classes and the classes which don't derive from W
+    template<std::size_t I, typename W, bool = (I < _dense<W>::size)>
+    struct _method_class
+    {
+        typedef void type;
+    };
+
+    template<std::size_t I, typename W>
+    struct _method_class<I, W, true>
+    {
+        typedef typename _type_at<I, typename _dense<W>::classes>::type C;
+        typedef typename std::conditional<std::is_base_of<typename std::remove_cv<W>::type, C>::value, C, void>::type type;
+    };
+
+    /**
+     * @return the stride of the dimension j of a table whose dimensions are the sizes n[0], ..., n[k - 1] (plus one for the unknown classes)
+     */
+    constexpr std::size_t _stride(const std::size_t * n, std::size_t j) noexcept
+    {
+        return j == 0 ? 1 : (n[j - 1] + 1) * _stride(n, j - 1);
+    }
+
+    // The table of the handlers to call: the cell of the classes of dense indices i0, i1, ... is i0 + i1 * stride(1) + ...
+    // (the first argument varies the fastest)
+    template<typename R, typename Tuple, typename W, typename A, typename J = typename _make_indices<W::size>::type>
+    struct _method_table;
+
+    template<typename R, typename Tuple, typename... W, typename... A, std::size_t... J>
+    struct _method_table<R, Tuple, type_list<W...>, type_list<A...>, _indices<J...>>
+    {
+        typedef R (*function)(Tuple &, W &...);
+
+        constexpr static std::size_t sizes[sizeof...(W)] = { _dense<W>::size... };
+        constexpr static std::size_t size = _stride(sizes, sizeof...(W));
+
+        template<std::size_t I>
+        struct cell
+        {
+            typedef type_list<typename _method_class<(I / _stride(sizes, J)) % (sizes[J] + 1), W>::type...> classes;
+            constexpr static int best = _all<!std::is_void<typename _method_class<(I / _stride(sizes, J)) % (sizes[J] + 1), W>::type>::value...>::value ? _best_method<classes, 0, -1, void, A...>::value : -1;
+            typedef typename std::conditional<(best >= 0), typename _type_at<static_cast<std::size_t>(best < 0 ? 0 : best), type_list<A...>>::type, type_list<>>::type arguments;
+            typedef _method_arm<R, Tuple, type_list<W...>, best, arguments> arm;
+        };
+
+        inline static std::size_t index(W &... w) noexcept
+            {
+                std::size_t i = 0;
+                const std::size_t indices[] = { _dense<W>::index(w)... };
+                for (std::size_t j = 0; j < sizeof...(W); ++j)
+                {
+                    i += indices[j] * _stride(sizes, j);
+                }
+                return i;
+            }
+    };
+
+    template<typename R, typename Tuple, typename... W, typename... A, std::size_t... J>
+    constexpr std::size_t _method_table<R, Tuple, type_list<W...>, type_list<A...>, _indices<J...>>::sizes[sizeof...(W)];
+
+    template<typename Table, typename I = typename _make_indices<Table::size>::type>
+    struct _method_cells;
+
+    template<typename Table, std::size_t... I>
+    struct _method_cells<Table, _indices<I...>>
+    {
+        constexpr static typename Table::function table[sizeof...(I)] = { &Table::template cell<I>::arm::call... };
+    };
+
+    template<typename Table, std::size_t... I>
+    constexpr typename Table::function _method_cells<Table, _indices<I...>>::table[sizeof...(I)];
+
+    /**
+     * Open multi-method: call the most specific handler for the dynamic classes of all the arguments.
+     * For example, with Signature = int(A &, A &) and the handlers [](B &, A &) { ... } and [](B &, C &) { ... },
+     * the second one is called for (B, C) or (D, C) and the first one for (B, B).
+     * The handlers are looked up in a table indexed by the dense indices of the arguments (its size is the product
+     * of the numbers of classes plus one) so the cost is the same whatever the number of handlers is.
+     * When no handler applies (or the most specific one is ambiguous, the first one is taken), a default value is returned.
+     */
+    template<typename Signature, typename... H>
+    class multimethod;
+
+    template<typename R, typename... W, typename... H>
+    class multimethod<R(W &...), H...>
+    {
+        typedef std::tuple<H...> Tuple;
+        typedef _method_table<R, Tuple, type_list<W...>, type_list<typename _callable<typename std::decay<H>::type>::arguments...>> Table;
+
+        static_assert(_all<(_callable<typename std::decay<H>::type>::arguments::size == sizeof...(W))...>::value, "The handlers must have the arity of the signature");
+
+        Tuple handlers;
+
+    public:
+
+        typedef R result_type;
+
+        multimethod(H... h) : handlers(std::forward<H>(h)...) { }
+
+        inline R operator()(W &... w)
+            {
+                return _method_cells<Table>::table[Table::index(w...)](handlers, w...);
+            }
+    };
+
+    /**
+     * @return a multimethod holding a copy of the handlers
+     * For example, auto collide = make_multimethod<void(Shape &, Shape &)>(handlers...).
+     */
+    template<typename Signature, typename... H>
+    inline multimethod<Signature, typename std::decay<H>::type...> make_multimethod(H &&... handlers)
+    {
+        return multimethod<Signature, typename std::decay<H>::type...>(std::forward<H>(handlers)...);
+    }
+
 } // namespace fastcast
 
 #endif // __cplusplus < 201103L
@@ -0,0 +1,331 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_ARENA_HXX__
+#define __FASTCAST_ARENA_HXX__ 1
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "fastcast.hxx"
+
+namespace fastcast
+{
+    /**
+     * An arena where each class of the hierarchy of Root is allocated in its own slabs.
+     * A slab is aligned on SlabSize bytes and begins with a header holding the id of the class of its objects,
+     * so instanceof, same and cast only need the address of an object: the object itself is not read.
+     * Thus the classes don't need to derive from fastcast::fcast (but they can).
+     *
+     * An object is allocated with a bump pointer in the current slab of its class or is taken from the list
+     * of the freed objects of its class, and it is freed in O(1).
+     * The arena is not thread safe and the objects still alive when it is destroyed are not destroyed.
+     * The functions taking a pointer must only be called with pointers to objects allocated in an arena
+     * with the same Root and SlabSize.
+     */
+    template<typename Root, typename U = typename id_type<Root>::type, std::size_t SlabSize = 65536>
+    class slab_arena
+    {
+        static_assert((SlabSize & (SlabSize - 1)) == 0, "The size of a slab must be a power of 2");
+
+        typedef typename hierarchy_of<Root>::type classes;
+        typedef typename _word_<U>::type word_type;
+
+        struct pool;
+
+        // The header of a slab
+        struct header
+        {
+            U id;
+            std::size_t first;
+            std::size_t size;
+            pool * owner;
+            header * next;
+            void * memory;
+        };
+
+        // The slabs of a class
+        struct pool
+        {
+            char * cursor;
+            char * end;
+            void * free;
+            header * slabs;
+            std::size_t size;
+            std::size_t first;
+            U id;
+            void (*destroy)(void *);
+        };
+
+        pool pools[classes::size];
+
+    public:
+
+        slab_arena()
+            {
+                init(classes());
+            }
+
+        ~slab_arena()
+            {
+                for (auto & p : pools)
+                {
+                    for (header * h = p.slabs; h;)
+                    {
+                        header * next = h->next;
+                        release(h->memory);
+                        h = next;
+                    }
+                }
+            }
+
+        slab_arena(const slab_arena &) = delete;
+        slab_arena & operator=(const slab_arena &) = delete;
+
+        /**
+         * @return the id of V
+         */
+        template<typename V>
+        constexpr static word_type id() noexcept
+            {
+                static_assert(fastcast::number_of_bits(_fcast_id_<Root, V>::id) <= 8 * sizeof(U), "The id of this class does not fit in the id type of the arena");
+                return static_cast<word_type>(_fcast_id_<Root, V>::id);
+            }
+
+        /**
+         * Allocate and construct a V (its fcast ids, if any, are set once V is constructed)
+         * @return the new object
+         */
+        template<typename V, typename... Args>
+        V * make(Args &&... args)
+            {
+                static_assert(_position<V, classes>::value < classes::size, "The class is not in the hierarchy of Root");
+                static_assert(sizeof(V) + sizeof(header) + alignof(V) <= SlabSize, "The class is too big for the slabs");
+
+                pool & p = pools[_position<V, classes>::value];
+                void * slot = p.free;
+                if (slot)
+                {
+                    p.free = *static_cast<void **>(slot);
+                }
+                else
+                {
+                    if (p.cursor == p.end)
+                    {
+                        grow(p);
+                    }
+                    slot = p.cursor;
+                    p.cursor += p.size;
+                }
+
+                V * v;
+                try
+                {
+                    v = new (slot) V(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    *static_cast<void **>(slot) = p.free;
+                    p.free = slot;
+                    throw;
+                }
+
+                fastcast::set_ids(*v);
+                return v;
+            }
+
+        /**
+         * Destroy an object allocated in this arena (w can point to any base of the object), nothing is done when w is null
+         */
+        template<typename W>
+        void destroy(W * w)
+            {
+                if (!w)
+                {
+                    return;
+                }
+
+                header * h = header_of(w);
+                char * base = reinterpret_cast<char *>(h);
+                const std::size_t offset = static_cast<std::size_t>(address(w) - base) - h->first;
+                char * object = base + h->first + (offset / h->size) * h->size;
+                pool & p = *h->owner;
+
+                p.destroy(object);
+                *reinterpret_cast<void **>(object) = p.free;
+                p.free = object;
+            }
+
+        /**
+         * @return true if w is an instance of V
+         */
+        template<typename V, typename W>
+        inline static bool instanceof(W * w) noexcept
+            {
+                constexpr word_type _id_ = id<V>();
+                constexpr word_type _mask_ = static_cast<word_type>(fastcast::id_mask(_id_));
+
+                return std::is_base_of<V, W>::value || (static_cast<word_type>(header_of(w)->id) & _mask_) == _id_;
+            }
+
+        /**
+         * @return true if w is an instance of V
+         */
+        template<typename V, typename W>
+        inline static bool instanceof(W & w) noexcept
+            {
+                return instanceof<V, W>(&w);
+            }
+
+        /**
+         * @return true if the underlying type of w is V
+         */
+        template<typename V, typename W>
+        inline static bool same(W * w) noexcept
+            {
+                return id<V>() == header_of(w)->id;
+            }
+
+        /**
+         * @return true if the underlying type of w is V
+         */
+        template<typename V, typename W>
+        inline static bool same(W & w) noexcept
+            {
+                return same<V, W>(&w);
+            }
+
+        /**
+         * Cast w to a V* pointer
+         * @return the casted pointer or nullptr if w is not an instance of V
+         */
+        template<typename V, typename W>
+        inline static V * cast(W * w) noexcept
+            {
+                return instanceof<V>(w) ? static_cast<V *>(w) : nullptr;
+            }
+
+        /**
+         * Cast w to a V reference
+         * @return the casted reference or throw a fastcast::bad_cast exception
+         */
+        template<typename V, typename W>
+        inline static V & cast(W & w)
+            {
+                return instanceof<V>(w) ? static_cast<V &>(w) : throw fastcast::bad_cast();
+            }
+
+    private:
+
+        template<typename W>
+        inline static char * address(W * w) noexcept
+            {
+                return const_cast<char *>(reinterpret_cast<const volatile char *>(w));
+            }
+
+        template<typename W>
+        inline static header * header_of(W * w) noexcept
+            {
+                return reinterpret_cast<header *>(reinterpret_cast<std::uintptr_t>(address(w)) & ~std::uintptr_t(SlabSize - 1));
+            }
+
+        template<typename V>
+        static void destroy_object(void * object)
+            {
+                static_cast<V *>(object)->~V();
+            }
+
+        template<typename V>
+        static pool make_pool()
+            {
+                // a freed slot holds a pointer to the next freed one
+                constexpr std::size_t align = alignof(V) > alignof(void *) ? alignof(V) : alignof(void *);
+                constexpr std::size_t size = sizeof(V) > sizeof(void *) ? sizeof(V) : sizeof(void *);
+
+                pool p;
+                p.cursor = nullptr;
+                p.end = nullptr;
+                p.free = nullptr;
+                p.slabs = nullptr;
+                p.size = (size + align - 1) / align * align;
+                p.first = (sizeof(header) + align - 1) / align * align;
+                p.id = static_cast<U>(id<V>());
+                p.destroy = &destroy_object<V>;
+
+                return p;
+            }
+
+        template<typename... C>
+        void init(type_list<C...>)
+            {
+                const pool p[] = { make_pool<C>()... };
+                for (std::size_t i = 0; i < sizeof...(C); ++i)
+                {
+                    pools[i] = p[i];
+                }
+            }
+
+        void grow(pool & p)
+            {
+                void * memory;
+                char * slab = static_cast<char *>(allocate(memory));
+                header * h = new (slab) header;
+
+                h->id = p.id;
+                h->first = p.first;
+                h->size = p.size;
+                h->owner = &p;
+                h->next = p.slabs;
+                h->memory = memory;
+                p.slabs = h;
+                p.cursor = slab + p.first;
+                p.end = p.cursor + (SlabSize - p.first) / p.size * p.size;
+            }
+
+        static void * allocate(void *& memory)
+            {
+#if defined(__cpp_aligned_new)
+                memory = ::operator new(SlabSize, std::align_val_t(SlabSize));
+                return memory;
+#else
+                memory = ::operator new(2 * SlabSize);
+                return reinterpret_cast<void *>((reinterpret_cast<std::uintptr_t>(memory) + SlabSize - 1) & ~std::uintptr_t(SlabSize - 1));
+#endif
+            }
+
+        static void release(void * memory)
+            {
+#if defined(__cpp_aligned_new)
+                ::operator delete(memory, std::align_val_t(SlabSize));
+#else
+                ::operator delete(memory);
+#endif
+            }
+    };
+
+} // namespace fastcast
+
+#endif // __FASTCAST_ARENA_HXX__
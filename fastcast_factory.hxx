@@ -0,0 +1,288 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_FACTORY_HXX__
+#define __FASTCAST_FACTORY_HXX__ 1
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "fastcast.hxx"
+
+namespace fastcast
+{
+    // The type of the stable tags
+    typedef uint32_t fcast_tag_t;
+
+    /**
+     * @return the FNV-1a hash of the string s (a tag computed from a name)
+     */
+    constexpr fcast_tag_t tag_hash(const char * s, fcast_tag_t h = 2166136261u) noexcept
+    {
+        return *s ? tag_hash(s + 1, static_cast<fcast_tag_t>((h ^ static_cast<unsigned char>(*s)) * 16777619u)) : h;
+    }
+
+    /**
+     * The stable tag of the class V: unlike its id, it doesn't change when the children are reordered, so it can be
+     * written in a file or sent on the wire. A class gets a tag in defining a fcast_tag typedef:
+     *
+     *   typedef fastcast::tag<B, 42> fcast_tag;                                 // explicit tag
+     *   typedef fastcast::tag<B, fastcast::tag_hash("shapes.B")> fcast_tag;     // hash of a name
+     *
+     * The class is given so the tag of a parent is not inherited by its children.
+     */
+    template<typename V, fcast_tag_t N>
+    struct tag
+    {
+        static_assert(N != 0, "0 is not a valid tag");
+
+        typedef V type;
+        constexpr static fcast_tag_t value = N;
+    };
+
+    template<typename V, fcast_tag_t N>
+    constexpr fcast_tag_t tag<V, N>::value;
+
+    template<typename V, typename T>
+    struct _tag_of : std::integral_constant<fcast_tag_t, 0> { };
+
+    template<typename V, fcast_tag_t N>
+    struct _tag_of<V, tag<V, N>> : std::integral_constant<fcast_tag_t, N> { };
+
+    // The tag of V or 0 if V has no tag
+    template<typename V, typename = void>
+    struct tag_of : std::integral_constant<fcast_tag_t, 0> { };
+
+    template<typename V>
+    struct tag_of<V, decltype(void(static_cast<typename V::fcast_tag *>(nullptr)))> : _tag_of<V, typename V::fcast_tag> { };
+
+    /**
+     * @return true if the non-zero key k is in ids[lo..hi[
+     */
+    template<typename Keys>
+    constexpr bool _contains_key(_wide_id_t k, std::size_t lo, std::size_t hi) noexcept
+    {
+        return hi - lo == 0 ? false : (hi - lo == 1 ? Keys::ids[lo] == k : _contains_key<Keys>(k, lo, lo + (hi - lo) / 2) || _contains_key<Keys>(k, lo + (hi - lo) / 2, hi));
+    }
+
+    /**
+     * @return true if a non-zero key of ids[lo..hi[ is also in ids[lo + 1..n[
+     */
+    template<typename Keys>
+    constexpr bool _duplicate_key(std::size_t lo, std::size_t hi, std::size_t n) noexcept
+    {
+        return hi - lo == 0 ? false : (hi - lo == 1 ? Keys::ids[lo] && _contains_key<Keys>(Keys::ids[lo], lo + 1, n) : _duplicate_key<Keys>(lo, lo + (hi - lo) / 2, n) || _duplicate_key<Keys>(lo + (hi - lo) / 2, hi, n));
+    }
+
+    template<typename L>
+    struct _unique_tags;
+
+    template<typename... C>
+    struct _unique_tags<type_list<C...>> : std::integral_constant<bool, !_duplicate_key<_key_list<tag_of<C>::value...>>(0, sizeof...(C), sizeof...(C))>
+    {
+    };
+
+    // true when the classes of the hierarchy of Root have different tags
+    template<typename Root>
+    struct unique_tags : _unique_tags<typename hierarchy_of<Root>::type>
+    {
+    };
+
+    // The ways a factory builds an object (create<V> is only used when V is constructible from Args)
+    template<typename Root, typename... Args>
+    struct _factory_new
+    {
+        typedef Root * (*function)(Args &&...);
+
+        template<typename V>
+        static Root * create(Args &&... args)
+            {
+                return make<V>(std::forward<Args>(args)...);
+            }
+    };
+
+    template<typename Root, typename... Args>
+    struct _factory_construct
+    {
+        typedef Root * (*function)(void *, Args &&...);
+
+        template<typename V>
+        static Root * create(void * where, Args &&... args)
+            {
+                return construct<V>(where, std::forward<Args>(args)...);
+            }
+    };
+
+    template<typename Root, typename Arena, typename... Args>
+    struct _factory_arena
+    {
+        typedef Root * (*function)(Arena &, Args &&...);
+
+        template<typename V>
+        static Root * create(Arena & arena, Args &&... args)
+            {
+                return arena.template make<V>(std::forward<Args>(args)...);
+            }
+    };
+
+    // The function building each class of L (nullptr when the class has no tag or cannot be built from Args) followed by nullptr
+    template<typename Op, typename L, typename... Args>
+    struct _factory_table;
+
+    template<typename Op, typename... C, typename... Args>
+    struct _factory_table<Op, type_list<C...>, Args...>
+    {
+        typedef typename Op::function function;
+
+        template<typename V>
+        constexpr static function entry(std::true_type) noexcept
+            {
+                return &Op::template create<V>;
+            }
+
+        template<typename V>
+        constexpr static function entry(std::false_type) noexcept
+            {
+                return nullptr;
+            }
+
+        constexpr static function table[sizeof...(C) + 1] = { entry<C>(std::integral_constant<bool, tag_of<C>::value != 0 && std::is_constructible<C, Args...>::value>())..., nullptr };
+    };
+
+    template<typename Op, typename... C, typename... Args>
+    constexpr typename Op::function _factory_table<Op, type_list<C...>, Args...>::table[sizeof...(C) + 1];
+
+    template<typename L>
+    struct _max_size;
+
+    template<typename... C>
+    struct _max_size<type_list<C...>>
+    {
+        constexpr static std::size_t size = _key_list<(tag_of<C>::value ? sizeof(C) : 0)...>::max();
+        constexpr static std::size_t align = _key_list<(tag_of<C>::value ? alignof(C) : 0)...>::max();
+    };
+
+    /**
+     * Build the objects of the hierarchy of Root from their tags (have a look at fastcast::tag):
+     * the tag gives the position of the class in a constant table (or in a hash table when the tags are greater
+     * than 2^FASTCAST_DIRECT_INDEX_BITS) and the position gives the function building the class in a constant table.
+     * The tags are checked at compile time: two classes cannot have the same tag.
+     * The ids of the objects are set once they are constructed (see fastcast::make).
+     */
+    template<typename Root>
+    class factory
+    {
+        typedef typename hierarchy_of<Root>::type classes;
+
+        static_assert(unique_tags<Root>::value, "Two classes of the hierarchy have the same tag");
+
+        template<typename L>
+        struct _index;
+
+        template<typename... C>
+        struct _index<type_list<C...>>
+        {
+            typedef _key_index<uint64_t, tag_of<C>::value...> type;
+        };
+
+        typedef typename _index<classes>::type index;
+
+    public:
+
+        typedef fcast_tag_t tag_type;
+
+        // The size and the alignment of the biggest class having a tag (for the storage given to construct)
+        constexpr static std::size_t max_size = _max_size<classes>::size;
+        constexpr static std::size_t max_align = _max_size<classes>::align;
+
+        /**
+         * @return the tag of V
+         */
+        template<typename V>
+        constexpr static tag_type tag() noexcept
+            {
+                static_assert(tag_of<V>::value != 0, "This class has no tag");
+                return tag_of<V>::value;
+            }
+
+        /**
+         * @return true if a class has the tag t
+         */
+        static bool contains(tag_type t) noexcept
+            {
+                return index::get(t) != classes::size;
+            }
+
+        /**
+         * Build the class having the tag t with new
+         * @return the new object or nullptr if no class has the tag t or if this class cannot be built from args
+         */
+        template<typename... Args>
+        static Root * make(tag_type t, Args &&... args)
+            {
+                typedef _factory_table<_factory_new<Root, Args...>, classes, Args...> table;
+
+                const typename table::function f = table::table[index::get(t)];
+                return f ? f(std::forward<Args>(args)...) : nullptr;
+            }
+
+        /**
+         * Build the class having the tag t at where
+         * (where must have room for max_size bytes and be aligned on max_align)
+         * @return the new object or nullptr if no class has the tag t or if this class cannot be built from args
+         */
+        template<typename... Args>
+        static Root * construct(void * where, tag_type t, Args &&... args)
+            {
+                typedef _factory_table<_factory_construct<Root, Args...>, classes, Args...> table;
+
+                const typename table::function f = table::table[index::get(t)];
+                return f ? f(where, std::forward<Args>(args)...) : nullptr;
+            }
+
+        /**
+         * Build the class having the tag t in an arena (for example a fastcast::slab_arena<Root>)
+         * @return the new object or nullptr if no class has the tag t or if this class cannot be built from args
+         */
+        template<typename Arena, typename... Args>
+        static Root * make_in(Arena & arena, tag_type t, Args &&... args)
+            {
+                typedef _factory_table<_factory_arena<Root, Arena, Args...>, classes, Args...> table;
+
+                const typename table::function f = table::table[index::get(t)];
+                return f ? f(arena, std::forward<Args>(args)...) : nullptr;
+            }
+    };
+
+    template<typename Root>
+    constexpr std::size_t factory<Root>::max_size;
+
+    template<typename Root>
+    constexpr std::size_t factory<Root>::max_align;
+
+} // namespace fastcast
+
+#endif // __FASTCAST_FACTORY_HXX__
@@ -0,0 +1,204 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_HYBRID_HXX__
+#define __FASTCAST_HYBRID_HXX__ 1
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "fastcast.hxx"
+
+// The number of entries of the cache of each target class of hybrid_cast (a power of 2)
+#ifndef FASTCAST_HYBRID_CACHE_SIZE
+# define FASTCAST_HYBRID_CACHE_SIZE 256
+#endif
+
+namespace fastcast
+{
+    // true when X has a fcast_hierarchy (its own or the one of a base class)
+    template<typename X, typename = void>
+    struct _has_hierarchy : std::false_type { };
+
+    template<typename X>
+    struct _has_hierarchy<X, decltype(void(static_cast<typename X::fcast_hierarchy *>(nullptr)))> : std::true_type { };
+
+    // true when the ids can be used to cast a W * to a V *: V is a class of the hierarchy of the root of W
+    // (W can be a class deriving from a class of the hierarchy without being in the hierarchy)
+    template<typename V, typename W, bool = _has_hierarchy<W>::value>
+    struct _hybrid_ids : std::false_type { };
+
+    template<typename V, typename W>
+    struct _hybrid_ids<V, W, true> : std::integral_constant<bool, (_position<V, typename _dense<W>::classes>::value < _dense<W>::classes::size)>
+    {
+    };
+
+    /**
+     * The results of dynamic_cast<V *> keyed by the virtual table pointer of the argument: a virtual table is the one of a subobject
+     * of a given class, so the offset between the argument and the result only depends on it (Itanium C++ ABI, where the virtual
+     * table pointer of a polymorphic class is at its beginning).
+     * The cache is an open addressing table where a thread claims an entry with a compare-and-swap on the key, then publishes the offset:
+     * no lock is taken and a reader which finds an entry being published calls dynamic_cast. When the cache is full, dynamic_cast is called.
+     */
+    template<typename V>
+    class _dynamic_cache
+    {
+        static_assert((FASTCAST_HYBRID_CACHE_SIZE & (FASTCAST_HYBRID_CACHE_SIZE - 1)) == 0, "The size of the cache must be a power of 2");
+
+        constexpr static std::ptrdiff_t none = PTRDIFF_MIN;
+        constexpr static std::ptrdiff_t pending = PTRDIFF_MIN + 1;
+
+        struct entry
+        {
+            std::atomic<const void *> vtable;
+            std::atomic<std::ptrdiff_t> offset;
+
+            constexpr entry() noexcept : vtable(nullptr), offset(pending) { }
+        };
+
+        // constant initialized, so it can be used during the dynamic initialization of the other static objects
+        struct table
+        {
+            entry entries[FASTCAST_HYBRID_CACHE_SIZE];
+
+            constexpr table() noexcept : entries() { }
+        };
+
+        // one table by target class, shared by all the static types of the arguments (their virtual tables are different)
+        static table t;
+
+        inline static std::size_t hash(const void * vtable) noexcept
+            {
+                const uint64_t x = static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(vtable) >> 3) * 0x9E3779B97F4A7C15ull;
+                return static_cast<std::size_t>(x >> 32) & (FASTCAST_HYBRID_CACHE_SIZE - 1);
+            }
+
+        template<typename W>
+        inline static char * address(W * w) noexcept
+            {
+                return const_cast<char *>(reinterpret_cast<const volatile char *>(w));
+            }
+
+        template<typename W>
+        inline static std::ptrdiff_t offset(W * w, V * v) noexcept
+            {
+                return v ? address(v) - address(w) : none;
+            }
+
+    public:
+
+        /**
+         * @return dynamic_cast<V *>(w) (w must not be null)
+         */
+        template<typename W>
+        static V * cast(W * w)
+            {
+                static_assert(std::is_polymorphic<W>::value, "The argument of hybrid_cast must be polymorphic");
+
+                const void * vtable = *reinterpret_cast<const void * const *>(address(w));
+                std::size_t h = hash(vtable);
+                for (std::size_t n = 0; n < FASTCAST_HYBRID_CACHE_SIZE; ++n, h = (h + 1) & (FASTCAST_HYBRID_CACHE_SIZE - 1))
+                {
+                    entry & e = t.entries[h];
+                    const void * key = e.vtable.load(std::memory_order_acquire);
+                    if (key == vtable)
+                    {
+                        const std::ptrdiff_t o = e.offset.load(std::memory_order_acquire);
+                        if (o == pending)
+                        {
+                            break;
+                        }
+                        return o == none ? nullptr : reinterpret_cast<V *>(address(w) + o);
+                    }
+                    if (!key)
+                    {
+                        V * const v = dynamic_cast<V *>(w);
+                        if (e.vtable.compare_exchange_strong(key, vtable, std::memory_order_acq_rel, std::memory_order_acquire))
+                        {
+                            e.offset.store(offset(w, v), std::memory_order_release);
+                            return v;
+                        }
+                        if (key == vtable)
+                        {
+                            return v;
+                        }
+                        // another virtual table took this entry
+                    }
+                }
+
+                return dynamic_cast<V *>(w);
+            }
+    };
+
+    template<typename V>
+    constexpr std::ptrdiff_t _dynamic_cache<V>::none;
+
+    template<typename V>
+    constexpr std::ptrdiff_t _dynamic_cache<V>::pending;
+
+    template<typename V>
+    typename _dynamic_cache<V>::table _dynamic_cache<V>::t;
+
+    template<typename V, typename W>
+    inline V * _hybrid_cast(W * w, std::true_type) noexcept
+    {
+        typename _dense<W>::root * const r = w;
+        return _dense<W>::fcast::template cast<V>(r);
+    }
+
+    template<typename V, typename W>
+    inline V * _hybrid_cast(W * w, std::false_type)
+    {
+        return _dynamic_cache<V>::cast(w);
+    }
+
+    /**
+     * Cast w to a V * with the ids when V is a class of the hierarchy of the root of W (the classes deriving from a class of the hierarchy
+     * without being in the hierarchy have the id of this class, so the result is right), else with dynamic_cast
+     * whose results are cached by virtual table and by target: a repeated cast is a probe in a hash table.
+     * The classes of the hierarchies must set their id in their constructors.
+     * @return the casted pointer or nullptr if w is null or is not an instance of V
+     */
+    template<typename V, typename W>
+    inline V * hybrid_cast(W * w)
+    {
+        return w ? _hybrid_cast<V>(w, _hybrid_ids<V, W>()) : nullptr;
+    }
+
+    /**
+     * Cast w to a V reference (see hybrid_cast(W *))
+     * @return the casted reference or throw a fastcast::bad_cast exception
+     */
+    template<typename V, typename W>
+    inline V & hybrid_cast(W & w)
+    {
+        V * const v = hybrid_cast<V>(&w);
+        return v ? *v : throw fastcast::bad_cast();
+    }
+
+} // namespace fastcast
+
+#endif // __FASTCAST_HYBRID_HXX__
@@ -0,0 +1,272 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_INDEX_HXX__
+#define __FASTCAST_INDEX_HXX__ 1
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "fastcast.hxx"
+
+namespace fastcast
+{
+    /**
+     * @return x with its bits in reverse order
+     */
+    inline uint64_t reverse_bits(uint64_t x) noexcept
+    {
+        x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+        x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+        x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+#if defined(__GNUC__)
+        return __builtin_bswap64(x);
+#else
+        x = ((x >> 8) & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+        x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+        return (x >> 32) | (x << 32);
+#endif
+    }
+
+#if defined(__SIZEOF_INT128__)
+    __extension__ inline unsigned __int128 reverse_bits(unsigned __int128 x) noexcept
+    {
+        return (static_cast<unsigned __int128>(reverse_bits(static_cast<uint64_t>(x))) << 64) | reverse_bits(static_cast<uint64_t>(x >> 64));
+    }
+#endif
+
+    /**
+     * The order of the objects in a type_sorted_index: the ids are compared in reading their bits from the lowest one.
+     * The id of a subclass of V ends with the id of V, so once the objects are sorted by their bit-reversed id
+     * the instances of V (and of its subclasses) are contiguous: their keys are in [key(id of V), last(id of V)].
+     */
+    template<typename Word>
+    struct _type_order
+    {
+        inline static Word key(Word id) noexcept
+            {
+                return reverse_bits(id);
+            }
+
+        inline static Word last(Word id) noexcept
+            {
+                // the mask of the bits of id
+                Word mask = id;
+                for (unsigned int s = 1; s < 8 * sizeof(Word); s <<= 1)
+                {
+                    mask |= mask >> s;
+                }
+
+                return reverse_bits(id) | ~reverse_bits(mask);
+            }
+    };
+
+    template<typename W>
+    struct _index_of
+    {
+        typedef typename _dense<W>::fcast fcast;
+        typedef typename fcast::word_type word_type;
+        typedef _type_order<word_type> order;
+
+        inline static word_type key(const W * w) noexcept
+            {
+                return order::key(static_cast<word_type>(static_cast<const fcast &>(*w)._fcast_id));
+            }
+
+        template<typename V>
+        inline static std::pair<word_type, word_type> keys() noexcept(!_is_plugin<V>::value)
+            {
+                const word_type id = fcast::template id_of<V>();
+                return std::make_pair(order::key(id), order::last(id));
+            }
+    };
+
+    /**
+     * Sort an array of pointers by type: the instances of each class (and of its subclasses) become contiguous
+     * (have a look at type_range)
+     */
+    template<typename W>
+    void sort_by_type(W ** first, W ** last)
+    {
+        std::sort(first, last, [](const W * a, const W * b) { return _index_of<W>::key(a) < _index_of<W>::key(b); });
+    }
+
+    /**
+     * @return the range of the instances of V in an array sorted with sort_by_type (found with two binary searches)
+     */
+    template<typename V, typename W>
+    std::pair<W **, W **> type_range(W ** first, W ** last)
+    {
+        typedef typename _index_of<W>::word_type word_type;
+        const std::pair<word_type, word_type> keys = _index_of<W>::template keys<V>();
+
+        W ** begin = std::lower_bound(first, last, keys.first, [](const W * w, word_type k) { return _index_of<W>::key(w) < k; });
+        W ** end = std::upper_bound(begin, last, keys.second, [](word_type k, const W * w) { return k < _index_of<W>::key(w); });
+
+        return std::make_pair(begin, end);
+    }
+
+    /**
+     * A set of objects of the hierarchy of Root kept in type order: the objects of each class are in a bucket
+     * and the buckets are sorted by the bit-reversed id of their class. So the instances of V (and of its subclasses)
+     * are in a contiguous range of buckets found with a binary search, and they are visited without any type test.
+     *
+     * An object is inserted in O(log(number of classes)) and erased in O(log(number of classes) + size of its bucket)
+     * (the bucket is searched from its end, so the last inserted objects are erased first).
+     * The id of an object must not change while it is in the index. The index is not thread safe.
+     */
+    template<typename Root>
+    class type_sorted_index
+    {
+        typedef _index_of<Root> index_of;
+        typedef typename index_of::word_type word_type;
+
+        struct bucket
+        {
+            word_type key;
+            std::vector<Root *> objects;
+        };
+
+        std::vector<bucket> buckets;
+        std::size_t _size;
+
+    public:
+
+        type_sorted_index() : _size(0) { }
+
+        /**
+         * Add an object (its id must be set)
+         */
+        void insert(Root * r)
+            {
+                const word_type key = index_of::key(r);
+                auto i = find(key);
+                if (i == buckets.end() || i->key != key)
+                {
+                    i = buckets.insert(i, bucket { key, std::vector<Root *>() });
+                }
+                i->objects.push_back(r);
+                ++_size;
+            }
+
+        /**
+         * Remove an object
+         * @return false if the object was not in the index
+         */
+        bool erase(Root * r)
+            {
+                const word_type key = index_of::key(r);
+                auto i = find(key);
+                if (i != buckets.end() && i->key == key)
+                {
+                    std::vector<Root *> & objects = i->objects;
+                    for (std::size_t j = objects.size(); j--;)
+                    {
+                        if (objects[j] == r)
+                        {
+                            objects[j] = objects.back();
+                            objects.pop_back();
+                            --_size;
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
+            }
+
+        void clear()
+            {
+                buckets.clear();
+                _size = 0;
+            }
+
+        std::size_t size() const
+            {
+                return _size;
+            }
+
+        bool empty() const
+            {
+                return !_size;
+            }
+
+        /**
+         * @return the number of instances of V
+         */
+        template<typename V>
+        std::size_t count() const
+            {
+                std::size_t n = 0;
+                const std::pair<const bucket *, const bucket *> r = range<V>();
+                for (const bucket * b = r.first; b != r.second; ++b)
+                {
+                    n += b->objects.size();
+                }
+
+                return n;
+            }
+
+        /**
+         * Call f(V &) for each instance of V
+         */
+        template<typename V, typename F>
+        void for_each(F f) const
+            {
+                const std::pair<const bucket *, const bucket *> r = range<V>();
+                for (const bucket * b = r.first; b != r.second; ++b)
+                {
+                    for (Root * o : b->objects)
+                    {
+                        f(*static_cast<V *>(o));
+                    }
+                }
+            }
+
+    private:
+
+        typename std::vector<bucket>::iterator find(word_type key)
+            {
+                return std::lower_bound(buckets.begin(), buckets.end(), key, [](const bucket & b, word_type k) { return b.key < k; });
+            }
+
+        template<typename V>
+        std::pair<const bucket *, const bucket *> range() const
+            {
+                const std::pair<word_type, word_type> keys = index_of::template keys<V>();
+                const bucket * first = buckets.data();
+                const bucket * last = first + buckets.size();
+                const bucket * begin = std::lower_bound(first, last, keys.first, [](const bucket & b, word_type k) { return b.key < k; });
+                const bucket * end = std::upper_bound(begin, last, keys.second, [](word_type k, const bucket & b) { return k < b.key; });
+
+                return std::make_pair(begin, end);
+            }
+    };
+
+} // namespace fastcast
+
+#endif // __FASTCAST_INDEX_HXX__
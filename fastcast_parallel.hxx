@@ -0,0 +1,419 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_PARALLEL_HXX__
+#define __FASTCAST_PARALLEL_HXX__ 1
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fastcast.hxx"
+
+// The number of pointers in a chunk of bucket_by_type (a chunk is the unit of work of the pool)
+#ifndef FASTCAST_BUCKET_CHUNK
+# define FASTCAST_BUCKET_CHUNK 16384
+#endif
+
+namespace fastcast
+{
+    /**
+     * A pool of threads running the tasks [0, n[ of a job: the tasks are split in one range per worker,
+     * a worker takes the tasks from the front of its range and, when its range is empty, steals the back half
+     * of the range of another worker. The thread calling run is one of the workers.
+     * The tasks must not throw.
+     */
+    class work_stealing_pool
+    {
+        // The tasks still to run by a worker (padded so two lanes don't share a cache line: the owner and the thieves lock it)
+        struct lane
+        {
+            std::mutex mutex;
+            std::size_t begin;
+            std::size_t end;
+            char padding[64];
+
+            lane() : begin(0), end(0) { }
+        };
+
+        std::unique_ptr<lane[]> lanes;
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        unsigned long long generation;
+        unsigned int running;
+        bool stop;
+
+        // The current job: task(data, i, worker)
+        void (*task)(void *, std::size_t, unsigned int);
+        void * data;
+
+    public:
+
+        /**
+         * Build a pool of n workers (the calling thread and n - 1 threads)
+         */
+        explicit work_stealing_pool(unsigned int n = std::thread::hardware_concurrency()) : lanes(new lane[n ? n : 1]), generation(0), running(0), stop(false), task(nullptr), data(nullptr)
+            {
+                for (unsigned int w = 1; w < n; ++w)
+                {
+                    threads.emplace_back([this, w]() { loop(w); });
+                }
+            }
+
+        work_stealing_pool(const work_stealing_pool &) = delete;
+        work_stealing_pool & operator=(const work_stealing_pool &) = delete;
+
+        ~work_stealing_pool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                }
+                wake.notify_all();
+                for (auto & t : threads)
+                {
+                    t.join();
+                }
+            }
+
+        /**
+         * @return the number of workers
+         */
+        unsigned int size() const noexcept
+            {
+                return static_cast<unsigned int>(threads.size()) + 1;
+            }
+
+        /**
+         * Call f(i, worker) for each i in [0, n[ (worker is in [0, size()[) and wait until all the calls are done
+         * The jobs must not be run concurrently.
+         */
+        template<typename F>
+        void run(std::size_t n, F f)
+            {
+                const unsigned int workers = size();
+                for (unsigned int w = 0; w < workers; ++w)
+                {
+                    lanes[w].begin = n * w / workers;
+                    lanes[w].end = n * (w + 1) / workers;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    task = [](void * d, std::size_t i, unsigned int w) { (*static_cast<F *>(d))(i, w); };
+                    data = &f;
+                    running = workers - 1;
+                    ++generation;
+                }
+                wake.notify_all();
+
+                work(0);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this]() { return !running; });
+            }
+
+    private:
+
+        void loop(unsigned int w)
+            {
+                unsigned long long seen = 0;
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                {
+                    wake.wait(lock, [this, seen]() { return stop || generation != seen; });
+                    if (stop)
+                    {
+                        return;
+                    }
+                    seen = generation;
+
+                    lock.unlock();
+                    work(w);
+                    lock.lock();
+
+                    if (!--running)
+                    {
+                        done.notify_one();
+                    }
+                }
+            }
+
+        void work(unsigned int w)
+            {
+                std::size_t i;
+                while (take(w, i) || steal(w, i))
+                {
+                    task(data, i, w);
+                }
+            }
+
+        bool take(unsigned int w, std::size_t & i)
+            {
+                lane & l = lanes[w];
+                std::lock_guard<std::mutex> lock(l.mutex);
+                if (l.begin == l.end)
+                {
+                    return false;
+                }
+                i = l.begin++;
+
+                return true;
+            }
+
+        bool steal(unsigned int w, std::size_t & i)
+            {
+                const unsigned int workers = size();
+                for (unsigned int k = 1; k < workers; ++k)
+                {
+                    std::size_t begin, end;
+                    {
+                        lane & victim = lanes[(w + k) % workers];
+                        std::lock_guard<std::mutex> lock(victim.mutex);
+                        if (victim.begin == victim.end)
+                        {
+                            continue;
+                        }
+                        // take the back half (and at least one task)
+                        end = victim.end;
+                        begin = victim.begin + (victim.end - victim.begin) / 2;
+                        victim.end = begin;
+                    }
+
+                    // the first stolen task is run now, the others go in the range of the thief
+                    lane & l = lanes[w];
+                    std::lock_guard<std::mutex> lock(l.mutex);
+                    i = begin;
+                    l.begin = begin + 1;
+                    l.end = end;
+
+                    return true;
+                }
+
+                return false;
+            }
+    };
+
+    // The smallest unsigned type holding a bucket number in [0, N[
+    template<std::size_t N>
+    struct _bucket_type
+    {
+        typedef typename std::conditional<(N <= 0x100), uint8_t, typename std::conditional<(N <= 0x10000), uint16_t, uint32_t>::type>::type type;
+    };
+
+    // The bucket of an id: the bucket of the first class of V... having the object among its instances
+    template<typename F, typename... V>
+    struct _bucket_of;
+
+    template<typename F>
+    struct _bucket_of<F>
+    {
+        inline static std::size_t get(typename F::word_type, std::size_t i) noexcept
+            {
+                return i;
+            }
+    };
+
+    template<typename F, typename V, typename... Vs>
+    struct _bucket_of<F, V, Vs...>
+    {
+        static_assert(!_is_plugin<V>::value, "bucket_by_type cannot test a plugin class");
+
+        inline static std::size_t get(typename F::word_type id, std::size_t i) noexcept
+            {
+                return F::template _ends_with<V>(id, _id_test<V>()) ? i : _bucket_of<F, Vs...>::get(id, i + 1);
+            }
+    };
+
+    /**
+     * The objects of the hierarchy of Root split by type (the result of bucket_by_type):
+     *  - without V, there is one bucket for each class of the hierarchy (the instances of exactly this class, in the order
+     *    of their dense index) and a last bucket for the unknown classes (the plugins);
+     *  - else the bucket i has the objects whose first class of V... they are an instance of is the i-th one,
+     *    and the last bucket has the objects which are not an instance of any class of V...
+     * In each bucket, the objects are in the same order as in the input.
+     */
+    template<typename Root, typename... V>
+    class type_buckets
+    {
+        typedef typename _dense<Root>::fcast fcast;
+        typedef typename fcast::word_type word_type;
+
+        template<typename R, typename... U>
+        friend void bucket_by_type(R * const * first, R * const * last, work_stealing_pool & pool, type_buckets<R, U...> & out);
+
+        std::vector<Root *> objects;
+        std::vector<std::size_t> offsets;
+
+    public:
+
+        // The number of buckets
+        constexpr static std::size_t count = (sizeof...(V) ? sizeof...(V) : _dense<Root>::size) + 1;
+
+        type_buckets() : offsets(count + 1, 0) { }
+
+        /**
+         * @return the number of objects
+         */
+        std::size_t size() const noexcept
+            {
+                return objects.size();
+            }
+
+        /**
+         * @return the bucket i as a range of pointers
+         */
+        std::pair<Root * const *, Root * const *> bucket(std::size_t i) const noexcept
+            {
+                return std::make_pair(objects.data() + offsets[i], objects.data() + offsets[i + 1]);
+            }
+
+        /**
+         * @return the bucket of U (a class of V... or a class of the hierarchy when V... is empty)
+         */
+        template<typename U>
+        std::pair<Root * const *, Root * const *> bucket() const noexcept
+            {
+                typedef typename std::conditional<sizeof...(V) != 0, type_list<V...>, typename _dense<Root>::classes>::type list;
+                static_assert(_position<U, list>::value < list::size, "This class has no bucket (it is not one of the classes given to bucket_by_type or is not in the hierarchy)");
+
+                return bucket(_position<U, list>::value);
+            }
+
+        /**
+         * @return the last bucket (the objects of unknown classes or which are not an instance of any class of V...)
+         */
+        std::pair<Root * const *, Root * const *> others() const noexcept
+            {
+                return bucket(count - 1);
+            }
+
+        /**
+         * Call f(U &) for each object of the bucket of U
+         */
+        template<typename U, typename G>
+        void for_each(G f) const
+            {
+                const std::pair<Root * const *, Root * const *> r = bucket<U>();
+                for (Root * const * p = r.first; p != r.second; ++p)
+                {
+                    f(fcast::template cast_unchecked<U>(**p));
+                }
+            }
+
+    private:
+
+        inline static std::size_t bucket_of(const Root * r) noexcept
+            {
+                const word_type id = static_cast<word_type>(static_cast<const fcast &>(*r)._fcast_id);
+                return sizeof...(V) ? _bucket_of<fcast, V...>::get(id, 0) : _id_index<fcast, typename _dense<Root>::classes>::get(id);
+            }
+    };
+
+    template<typename Root, typename... V>
+    constexpr std::size_t type_buckets<Root, V...>::count;
+
+    /**
+     * Split the objects of [first, last[ by type in out (have a look at type_buckets) with the workers of pool.
+     * The pointers are cut in chunks of FASTCAST_BUCKET_CHUNK: each chunk reads the id of its objects once,
+     * keeps their bucket and counts the objects of each bucket; then the position of each chunk in each bucket is known
+     * and the chunks copy their pointers there. So the result doesn't depend on the number of workers nor on the stealing.
+     * The pointers must not be null.
+     */
+    template<typename Root, typename... V>
+    void bucket_by_type(Root * const * first, Root * const * last, work_stealing_pool & pool, type_buckets<Root, V...> & out)
+    {
+        typedef type_buckets<Root, V...> buckets;
+        typedef typename _bucket_type<buckets::count>::type bucket_type;
+        constexpr std::size_t B = buckets::count;
+        constexpr std::size_t chunk = FASTCAST_BUCKET_CHUNK;
+
+        const std::size_t n = static_cast<std::size_t>(last - first);
+        const std::size_t chunks = (n + chunk - 1) / chunk;
+        std::unique_ptr<bucket_type[]> which(new bucket_type[n]);
+        std::vector<std::size_t> counts(chunks * B, 0);
+
+        pool.run(chunks, [&](std::size_t c, unsigned int)
+                 {
+                     std::size_t * const count = counts.data() + c * B;
+                     const std::size_t end = std::min(n, (c + 1) * chunk);
+                     for (std::size_t i = c * chunk; i < end; ++i)
+                     {
+                         const std::size_t b = buckets::bucket_of(first[i]);
+                         which[i] = static_cast<bucket_type>(b);
+                         ++count[b];
+                     }
+                 });
+
+        // the counts become the positions where the chunks write: bucket by bucket, then chunk by chunk
+        std::size_t offset = 0;
+        for (std::size_t b = 0; b < B; ++b)
+        {
+            out.offsets[b] = offset;
+            for (std::size_t c = 0; c < chunks; ++c)
+            {
+                const std::size_t k = counts[c * B + b];
+                counts[c * B + b] = offset;
+                offset += k;
+            }
+        }
+        out.offsets[B] = offset;
+
+        out.objects.resize(n);
+        Root ** const objects = out.objects.data();
+        pool.run(chunks, [&](std::size_t c, unsigned int)
+                 {
+                     std::size_t * const position = counts.data() + c * B;
+                     const std::size_t end = std::min(n, (c + 1) * chunk);
+                     for (std::size_t i = c * chunk; i < end; ++i)
+                     {
+                         objects[position[which[i]]++] = first[i];
+                     }
+                 });
+    }
+
+    /**
+     * @return the objects of [first, last[ split by type (have a look at type_buckets)
+     */
+    template<typename Root, typename... V>
+    type_buckets<Root, V...> bucket_by_type(Root * const * first, Root * const * last, work_stealing_pool & pool)
+    {
+        type_buckets<Root, V...> out;
+        bucket_by_type(first, last, pool, out);
+        return out;
+    }
+
+} // namespace fastcast
+
+#endif // __FASTCAST_PARALLEL_HXX__
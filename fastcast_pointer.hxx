@@ -0,0 +1,263 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_POINTER_HXX__
+#define __FASTCAST_POINTER_HXX__ 1
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "fastcast.hxx"
+
+namespace fastcast
+{
+    /**
+     * An intrusive pointer: the reference count is held by the object and is managed by the functions
+     * intrusive_ptr_add_ref(T *) and intrusive_ptr_release(T *) found by argument-dependent lookup
+     * (the same hooks as boost::intrusive_ptr)
+     */
+    template<typename T>
+    class intrusive_ptr
+    {
+        T * p;
+
+    public:
+
+        typedef T element_type;
+
+        intrusive_ptr() noexcept : p(nullptr) { }
+
+        intrusive_ptr(T * t, bool add_ref = true) : p(t)
+            {
+                if (p && add_ref)
+                {
+                    intrusive_ptr_add_ref(p);
+                }
+            }
+
+        intrusive_ptr(const intrusive_ptr & o) : intrusive_ptr(o.p) { }
+
+        template<typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        intrusive_ptr(const intrusive_ptr<U> & o) : intrusive_ptr(o.get()) { }
+
+        intrusive_ptr(intrusive_ptr && o) noexcept : p(o.detach()) { }
+
+        template<typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        intrusive_ptr(intrusive_ptr<U> && o) noexcept : p(o.detach()) { }
+
+        ~intrusive_ptr()
+            {
+                if (p)
+                {
+                    intrusive_ptr_release(p);
+                }
+            }
+
+        intrusive_ptr & operator=(intrusive_ptr o) noexcept
+            {
+                swap(o);
+                return *this;
+            }
+
+        void reset() noexcept
+            {
+                intrusive_ptr().swap(*this);
+            }
+
+        void swap(intrusive_ptr & o) noexcept
+            {
+                std::swap(p, o.p);
+            }
+
+        /**
+         * Give up the ownership of the object without changing its reference count
+         * @return the pointer to the object
+         */
+        T * detach() noexcept
+            {
+                T * t = p;
+                p = nullptr;
+                return t;
+            }
+
+        T * get() const noexcept
+            {
+                return p;
+            }
+
+        T & operator*() const noexcept
+            {
+                return *p;
+            }
+
+        T * operator->() const noexcept
+            {
+                return p;
+            }
+
+        explicit operator bool() const noexcept
+            {
+                return p != nullptr;
+            }
+    };
+
+    template<typename T, typename U>
+    inline bool operator==(const intrusive_ptr<T> & a, const intrusive_ptr<U> & b) noexcept
+    {
+        return a.get() == b.get();
+    }
+
+    template<typename T, typename U>
+    inline bool operator!=(const intrusive_ptr<T> & a, const intrusive_ptr<U> & b) noexcept
+    {
+        return a.get() != b.get();
+    }
+
+    /**
+     * @return w cast to a V * with the fcast of the root of W, or nullptr if w is null or is not an instance of V
+     */
+    template<typename V, typename W>
+    inline V * _pointer_cast(W * w) noexcept
+    {
+        return w ? _dense<W>::fcast::template cast<V>(w) : nullptr;
+    }
+
+    /**
+     * Cast a shared pointer without RTTI (the reference count is incremented only when the cast succeeds)
+     * @return a shared pointer sharing the ownership of w or an empty one if w is not an instance of V
+     */
+    template<typename V, typename W>
+    inline std::shared_ptr<V> cast(const std::shared_ptr<W> & w) noexcept
+    {
+        V * const v = _pointer_cast<V>(w.get());
+        return v ? std::shared_ptr<V>(w, v) : std::shared_ptr<V>();
+    }
+
+    /**
+     * Cast a shared pointer and take its ownership when the cast succeeds (else w is not changed).
+     * With C++20 the control block is moved without any atomic operation,
+     * before C++20 the reference count is incremented then decremented.
+     * @return the casted shared pointer or an empty one if w is not an instance of V
+     */
+    template<typename V, typename W>
+    inline std::shared_ptr<V> cast(std::shared_ptr<W> && w) noexcept
+    {
+        V * const v = _pointer_cast<V>(w.get());
+        if (!v)
+        {
+            return std::shared_ptr<V>();
+        }
+#if __cplusplus > 201703L
+        return std::shared_ptr<V>(std::move(w), v);
+#else
+        std::shared_ptr<V> r(w, v);
+        w.reset();
+        return r;
+#endif
+    }
+
+    // The deleter of a casted unique pointer: a std::default_delete<W> becomes a std::default_delete<V> (W has a virtual destructor
+    // or the dynamic type is V), the other deleters are kept
+    template<typename D, typename V>
+    struct _cast_deleter
+    {
+        typedef D type;
+
+        inline static const D & copy(const D & d) noexcept
+            {
+                return d;
+            }
+
+        inline static D && move(D & d) noexcept
+            {
+                return std::forward<D>(d);
+            }
+    };
+
+    template<typename W, typename V>
+    struct _cast_deleter<std::default_delete<W>, V>
+    {
+        typedef std::default_delete<V> type;
+
+        inline static type copy(const std::default_delete<W> &) noexcept
+            {
+                return type();
+            }
+
+        inline static type move(std::default_delete<W> &) noexcept
+            {
+                return type();
+            }
+    };
+
+    /**
+     * Cast a unique pointer: the ownership is transferred only when the cast succeeds (else w is not changed)
+     * @return the casted unique pointer or an empty one if w is not an instance of V
+     * (a std::unique_ptr<W> gives a std::unique_ptr<V>, the other deleters are kept: they are copied on failure and moved on success)
+     */
+    template<typename V, typename W, typename D>
+    inline std::unique_ptr<V, typename _cast_deleter<D, V>::type> cast(std::unique_ptr<W, D> && w) noexcept(std::is_nothrow_move_constructible<D>::value && std::is_nothrow_copy_constructible<D>::value)
+    {
+        typedef _cast_deleter<D, V> deleter;
+
+        V * const v = _pointer_cast<V>(w.get());
+        if (!v)
+        {
+            return std::unique_ptr<V, typename deleter::type>(nullptr, deleter::copy(w.get_deleter()));
+        }
+        w.release();
+        return std::unique_ptr<V, typename deleter::type>(v, deleter::move(w.get_deleter()));
+    }
+
+    /**
+     * Cast an intrusive pointer (the reference count is incremented only when the cast succeeds)
+     * @return an intrusive pointer to the same object or an empty one if w is not an instance of V
+     */
+    template<typename V, typename W>
+    inline intrusive_ptr<V> cast(const intrusive_ptr<W> & w)
+    {
+        return intrusive_ptr<V>(_pointer_cast<V>(w.get()));
+    }
+
+    /**
+     * Cast an intrusive pointer and take its ownership when the cast succeeds (else w is not changed):
+     * the reference count is not changed
+     * @return the casted intrusive pointer or an empty one if w is not an instance of V
+     */
+    template<typename V, typename W>
+    inline intrusive_ptr<V> cast(intrusive_ptr<W> && w) noexcept
+    {
+        V * const v = _pointer_cast<V>(w.get());
+        if (v)
+        {
+            w.detach();
+        }
+        return intrusive_ptr<V>(v, false);
+    }
+
+} // namespace fastcast
+
+#endif // __FASTCAST_POINTER_HXX__
@@ -0,0 +1,412 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_PROFILE_HXX__
+#define __FASTCAST_PROFILE_HXX__ 1
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GNUG__)
+# include <cstdlib>
+# include <cxxabi.h>
+#endif
+
+#if defined(FASTCAST_PROFILE_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+# include <x86intrin.h>
+#endif
+
+// The number of (call site, dynamic id) pairs which can be counted by each thread
+#ifndef FASTCAST_PROFILE_CAPACITY
+# define FASTCAST_PROFILE_CAPACITY 4096
+#endif
+
+namespace fastcast
+{
+    /**
+     * The profiling mode is enabled in defining FASTCAST_PROFILE before including fastcast.hxx:
+     * each call to fcast::instanceof, fcast::same and fcast::cast is counted by (static type of the argument,
+     * target type, dynamic id) as a success or a failure. When FASTCAST_PROFILE_CYCLES is defined too,
+     * the time stamp counter (or the nanoseconds on the other platforms) spent in the calls is added up.
+     *
+     * Each thread counts in its own table (so no lock and no atomic read-modify-write is used)
+     * and the tables are merged when the report is built.
+     * When FASTCAST_PROFILE is not defined, this file is not included and the casts are not changed.
+     */
+    namespace profile
+    {
+        enum class op : unsigned char { instanceof, same, cast };
+
+        inline const char * op_name(op o)
+        {
+            return o == op::instanceof ? "instanceof" : (o == op::same ? "same" : "cast");
+        }
+
+        // A call site: the operation and the static types of the argument and of the target
+        struct site
+        {
+            op kind;
+            std::string source;
+            std::string target;
+        };
+
+        /**
+         * @return the name of T (demangled when possible)
+         */
+        template<typename T>
+        std::string type_name()
+        {
+            const char * name = typeid(T).name();
+#if defined(__GNUG__)
+            int status = 0;
+            char * demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            if (demangled)
+            {
+                std::string s(demangled);
+                std::free(demangled);
+                return s;
+            }
+#endif
+            return name;
+        }
+
+        template<op K, typename W, typename V>
+        inline const site * site_of()
+        {
+            static const site s { K, type_name<W>(), type_name<V>() };
+            return &s;
+        }
+
+        // A counter of a thread: only this thread writes it, so the increments are plain load and store
+        struct entry
+        {
+            std::atomic<const site *> where;
+            uint64_t lo;
+            uint64_t hi;
+            std::atomic<uint64_t> success;
+            std::atomic<uint64_t> failure;
+            std::atomic<uint64_t> cycles;
+        };
+
+        inline void _add(std::atomic<uint64_t> & counter, uint64_t n) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        // The counters of a thread (open addressing on the call site and the dynamic id)
+        struct thread_counters
+        {
+            entry entries[FASTCAST_PROFILE_CAPACITY];
+            std::atomic<uint64_t> dropped;
+            thread_counters * next;
+
+            thread_counters() : dropped(0), next(nullptr)
+                {
+                    for (auto & e : entries)
+                    {
+                        e.where.store(nullptr, std::memory_order_relaxed);
+                        e.lo = e.hi = 0;
+                        e.success.store(0, std::memory_order_relaxed);
+                        e.failure.store(0, std::memory_order_relaxed);
+                        e.cycles.store(0, std::memory_order_relaxed);
+                    }
+                }
+
+            entry * find(const site * s, uint64_t lo, uint64_t hi) noexcept
+                {
+                    const uint64_t x = reinterpret_cast<std::uintptr_t>(s) ^ lo ^ (hi * 0xC2B2AE3D27D4EB4Full);
+                    std::size_t h = static_cast<std::size_t>((x * 0x9E3779B97F4A7C15ull) >> 32) % FASTCAST_PROFILE_CAPACITY;
+                    for (std::size_t n = 0; n < FASTCAST_PROFILE_CAPACITY; ++n, h = (h + 1) % FASTCAST_PROFILE_CAPACITY)
+                    {
+                        entry & e = entries[h];
+                        const site * w = e.where.load(std::memory_order_relaxed);
+                        if (w == s && e.lo == lo && e.hi == hi)
+                        {
+                            return &e;
+                        }
+                        if (!w)
+                        {
+                            e.lo = lo;
+                            e.hi = hi;
+                            // the key is published after the id so a reader never sees a partial key
+                            e.where.store(s, std::memory_order_release);
+                            return &e;
+                        }
+                    }
+
+                    return nullptr;
+                }
+        };
+
+        // The list of the counters of all the threads (a thread pushes its counters once, they are never freed)
+        inline std::atomic<thread_counters *> & _threads() noexcept
+        {
+            static std::atomic<thread_counters *> head(nullptr);
+            return head;
+        }
+
+        inline thread_counters & _local()
+        {
+            static thread_local thread_counters * counters = nullptr;
+            if (!counters)
+            {
+                counters = new thread_counters();
+                std::atomic<thread_counters *> & head = _threads();
+                thread_counters * next = head.load(std::memory_order_relaxed);
+                do
+                {
+                    counters->next = next;
+                }
+                while (!head.compare_exchange_weak(next, counters, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            return *counters;
+        }
+
+        inline uint64_t _ticks() noexcept
+        {
+#if defined(FASTCAST_PROFILE_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+            return __rdtsc();
+#elif defined(FASTCAST_PROFILE_CYCLES)
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+            return 0;
+#endif
+        }
+
+        // Count a call from its construction to the call to operator()
+        template<op K, typename W, typename V>
+        class scope
+        {
+            uint64_t lo;
+            uint64_t hi;
+            uint64_t start;
+
+        public:
+
+            template<typename I>
+            explicit scope(I id) noexcept : lo(static_cast<uint64_t>(id)), hi(sizeof(I) > sizeof(uint64_t) ? static_cast<uint64_t>((id >> 32) >> 32) : 0), start(_ticks()) { }
+
+            /**
+             * Count the result r
+             * @return r
+             */
+            bool operator()(bool r) noexcept
+                {
+                    const uint64_t end = _ticks();
+                    try
+                    {
+                        thread_counters & counters = _local();
+                        if (entry * e = counters.find(site_of<K, W, V>(), lo, hi))
+                        {
+                            _add(r ? e->success : e->failure, 1);
+                            _add(e->cycles, end - start);
+                        }
+                        else
+                        {
+                            _add(counters.dropped, 1);
+                        }
+                    }
+                    catch (...)
+                    {
+                        // the call is not counted when the counters cannot be allocated
+                    }
+
+                    return r;
+                }
+        };
+
+        // A line of the report
+        struct record
+        {
+            const site * where;
+            uint64_t lo;
+            uint64_t hi;
+            uint64_t success;
+            uint64_t failure;
+            uint64_t cycles;
+
+            uint64_t calls() const
+                {
+                    return success + failure;
+                }
+        };
+
+        /**
+         * Merge the counters of all the threads
+         * @return the records sorted by decreasing number of calls
+         */
+        inline std::vector<record> report()
+        {
+            std::map<std::tuple<const site *, uint64_t, uint64_t>, record> merged;
+            for (thread_counters * t = _threads().load(std::memory_order_acquire); t; t = t->next)
+            {
+                for (const auto & e : t->entries)
+                {
+                    const site * s = e.where.load(std::memory_order_acquire);
+                    if (s)
+                    {
+                        record & r = merged.emplace(std::make_tuple(s, e.lo, e.hi), record { s, e.lo, e.hi, 0, 0, 0 }).first->second;
+                        r.success += e.success.load(std::memory_order_relaxed);
+                        r.failure += e.failure.load(std::memory_order_relaxed);
+                        r.cycles += e.cycles.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            std::vector<record> records;
+            for (const auto & m : merged)
+            {
+                if (m.second.calls())
+                {
+                    records.push_back(m.second);
+                }
+            }
+            std::stable_sort(records.begin(), records.end(), [](const record & a, const record & b) { return a.calls() > b.calls(); });
+
+            return records;
+        }
+
+        /**
+         * @return the number of calls which were not counted because a table of a thread was full
+         */
+        inline uint64_t dropped()
+        {
+            uint64_t n = 0;
+            for (thread_counters * t = _threads().load(std::memory_order_acquire); t; t = t->next)
+            {
+                n += t->dropped.load(std::memory_order_relaxed);
+            }
+
+            return n;
+        }
+
+        /**
+         * Set all the counters to zero (it should be called when no thread is casting)
+         */
+        inline void reset()
+        {
+            for (thread_counters * t = _threads().load(std::memory_order_acquire); t; t = t->next)
+            {
+                for (auto & e : t->entries)
+                {
+                    e.success.store(0, std::memory_order_relaxed);
+                    e.failure.store(0, std::memory_order_relaxed);
+                    e.cycles.store(0, std::memory_order_relaxed);
+                }
+                t->dropped.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        inline std::ostream & _write_id(std::ostream & out, const record & r)
+        {
+            const std::ios_base::fmtflags flags = out.flags();
+            out << "0x" << std::hex;
+            if (r.hi)
+            {
+                out << r.hi;
+                out.width(16);
+                out.fill('0');
+            }
+            out << r.lo;
+            out.flags(flags);
+
+            return out;
+        }
+
+        /**
+         * Write s as a JSON string: the quotes, the backslashes and the control characters are escaped
+         */
+        inline std::ostream & _write_json_string(std::ostream & out, const std::string & s)
+        {
+            static const char digits[] = "0123456789abcdef";
+            out << '"';
+            for (const char c : s)
+            {
+                const unsigned char u = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\')
+                {
+                    out << '\\' << c;
+                }
+                else if (u < 0x20)
+                {
+                    out << "\\u00" << digits[u >> 4] << digits[u & 0xF];
+                }
+                else
+                {
+                    out << c;
+                }
+            }
+
+            return out << '"';
+        }
+
+        /**
+         * Write the report as text: one line by (call site, dynamic id)
+         */
+        inline void write_text(std::ostream & out)
+        {
+            for (const auto & r : report())
+            {
+                out << op_name(r.where->kind) << '<' << r.where->target << ">(" << r.where->source << " *) on id ";
+                _write_id(out, r) << ": " << r.calls() << " calls, " << r.success << " successes, " << r.failure << " failures";
+#if defined(FASTCAST_PROFILE_CYCLES)
+                out << ", " << r.cycles << " cycles";
+#endif
+                out << std::endl;
+            }
+        }
+
+        /**
+         * Write the report as a JSON array
+         */
+        inline void write_json(std::ostream & out)
+        {
+            const std::vector<record> records = report();
+            out << '[' << std::endl;
+            for (std::size_t i = 0; i < records.size(); ++i)
+            {
+                const record & r = records[i];
+                out << "  { \"op\": \"" << op_name(r.where->kind) << "\", \"source\": ";
+                _write_json_string(out, r.where->source) << ", \"target\": ";
+                _write_json_string(out, r.where->target) << ", \"id\": \"";
+                _write_id(out, r) << "\", \"success\": " << r.success << ", \"failure\": " << r.failure << ", \"cycles\": " << r.cycles << " }" << (i + 1 < records.size() ? "," : "") << std::endl;
+            }
+            out << ']' << std::endl;
+        }
+
+    } // namespace profile
+
+} // namespace fastcast
+
+#endif // __FASTCAST_PROFILE_HXX__
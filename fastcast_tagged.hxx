@@ -0,0 +1,230 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_TAGGED_HXX__
+#define __FASTCAST_TAGGED_HXX__ 1
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#include "fastcast.hxx"
+
+// The number of high bits of a pointer which are not used by the addresses (x86-64 and AArch64 use 48 bits)
+#ifndef FASTCAST_TAG_BITS
+# define FASTCAST_TAG_BITS 16
+#endif
+
+namespace fastcast
+{
+    // True when the ids of the hierarchy of the root class Root fit in the tag of a tagged_ptr
+    template<typename Root>
+    struct fits_tag : std::integral_constant<bool, (id_bits<Root>::value <= FASTCAST_TAG_BITS)>
+    {
+    };
+
+    /**
+     * A pointer to an object of the hierarchy of the root class Root which carries the id of the object in its high bits:
+     * instanceof, same and cast test the tag with the same suffix test as fcast, so they never read the object.
+     * The id is read once, when the tagged pointer is built from a raw pointer, so the id of the object must be set
+     * and must not change while it is pointed by a tagged pointer. The plugin classes are not supported.
+     * The hierarchy is only needed in the member functions, so the classes of the hierarchy can have tagged pointers members.
+     */
+    template<typename Root>
+    class tagged_ptr
+    {
+        static_assert(sizeof(void *) == sizeof(uint64_t), "The tagged pointers need 64 bits pointers");
+
+        // the fcast of the hierarchy (the classes must be complete)
+        template<typename R>
+        struct _fcast
+        {
+            static_assert(fits_tag<R>::value, "The ids of this hierarchy don't fit in the tag (have a look at fastcast::id_bits)");
+
+            typedef typename _dense<R>::fcast type;
+        };
+
+        constexpr static unsigned int shift = 64 - FASTCAST_TAG_BITS;
+        constexpr static uint64_t address_mask = (uint64_t(1) << shift) - 1;
+
+        uint64_t bits;
+
+    public:
+
+        typedef typename uint_least<FASTCAST_TAG_BITS>::type tag_type;
+
+        tagged_ptr() noexcept : bits(0) { }
+
+        tagged_ptr(std::nullptr_t) noexcept : bits(0) { }
+
+        /**
+         * Tag r with the id of its object (read once here)
+         */
+        explicit tagged_ptr(Root * r) noexcept : bits(r ? (reinterpret_cast<uintptr_t>(r) | (static_cast<uint64_t>(static_cast<const typename _fcast<Root>::type *>(r)->_fcast_id) << shift)) : 0) { }
+
+        /**
+         * @return the raw pointer
+         */
+        Root * get() const noexcept
+            {
+                return reinterpret_cast<Root *>(static_cast<uintptr_t>(bits & address_mask));
+            }
+
+        /**
+         * @return the id of the object (0 for a null pointer)
+         */
+        tag_type id() const noexcept
+            {
+                return static_cast<tag_type>(bits >> shift);
+            }
+
+        Root & operator*() const noexcept
+            {
+                return *get();
+            }
+
+        Root * operator->() const noexcept
+            {
+                return get();
+            }
+
+        explicit operator bool() const noexcept
+            {
+                return bits != 0;
+            }
+
+        explicit operator Root *() const noexcept
+            {
+                return get();
+            }
+
+        void reset(Root * r = nullptr) noexcept
+            {
+                *this = tagged_ptr(r);
+            }
+
+        friend bool operator==(const tagged_ptr & a, const tagged_ptr & b) noexcept
+            {
+                return a.bits == b.bits;
+            }
+
+        friend bool operator!=(const tagged_ptr & a, const tagged_ptr & b) noexcept
+            {
+                return a.bits != b.bits;
+            }
+
+        /**
+         * @return true if the object is an instance of V (false for a null pointer)
+         */
+        template<typename V>
+        bool instanceof() const noexcept
+            {
+                static_assert(!_is_plugin<V>::value, "The plugin classes are not supported by tagged_ptr");
+
+                // the ids are not null, so the suffix test fails on a null pointer
+                typedef typename _fcast<Root>::type fcast;
+                return std::is_base_of<V, Root>::value ? bits != 0 : fcast::template _ends_with<V>(id(), _id_test<V>());
+            }
+
+        /**
+         * @return true if the underlying type of the object is V (false for a null pointer)
+         */
+        template<typename V>
+        bool same() const noexcept
+            {
+                static_assert(!_is_plugin<V>::value, "The plugin classes are not supported by tagged_ptr");
+
+                return id() == _fcast<Root>::type::template id<V>();
+            }
+
+        /**
+         * @return the pointer cast to a V * or nullptr if the object is not an instance of V
+         * (the object is only read when V derives from Root through a virtual base)
+         */
+        template<typename V>
+        V * cast() const noexcept
+            {
+                return instanceof<V>() ? _fcast<Root>::type::template _downcast<V>(get(), _static_downcast<Root, V>()) : nullptr;
+            }
+    };
+
+    template<typename Root>
+    constexpr unsigned int tagged_ptr<Root>::shift;
+
+    template<typename Root>
+    constexpr uint64_t tagged_ptr<Root>::address_mask;
+
+    /**
+     * @return true if p points to an instance of V (without reading the object)
+     */
+    template<typename V, typename Root>
+    inline bool instanceof(const tagged_ptr<Root> & p) noexcept
+    {
+        return p.template instanceof<V>();
+    }
+
+    /**
+     * @return true if the underlying type of the object pointed by p is V (without reading the object)
+     */
+    template<typename V, typename Root>
+    inline bool same(const tagged_ptr<Root> & p) noexcept
+    {
+        return p.template same<V>();
+    }
+
+    /**
+     * @return p cast to a V * or nullptr if p is null or does not point to an instance of V
+     */
+    template<typename V, typename Root>
+    inline V * cast(const tagged_ptr<Root> & p) noexcept
+    {
+        return p.template cast<V>();
+    }
+
+    /**
+     * @return r tagged with the id of its object
+     */
+    template<typename Root>
+    inline tagged_ptr<Root> make_tagged(Root * r) noexcept
+    {
+        return tagged_ptr<Root>(r);
+    }
+
+} // namespace fastcast
+
+namespace std
+{
+    template<typename Root>
+    struct hash<fastcast::tagged_ptr<Root>>
+    {
+        std::size_t operator()(const fastcast::tagged_ptr<Root> & p) const noexcept
+            {
+                return std::hash<Root *>()(p.get());
+            }
+    };
+}
+
+#endif // __FASTCAST_TAGGED_HXX__
@@ -0,0 +1,389 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FASTCAST_VALUE_HXX__
+#define __FASTCAST_VALUE_HXX__ 1
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "fastcast.hxx"
+
+namespace fastcast
+{
+    // The operations of a class stored in a poly_value (found with the id of the object)
+    template<typename Root>
+    struct _value_ops
+    {
+        void (*copy)(void *, const Root &);
+        void (*move)(void *, Root &);
+        void (*destroy)(Root &);
+    };
+
+    // A class can be stored in a poly_value when it is concrete, fits in the storage, is copyable and has a nothrow move
+    template<typename Root, typename V, std::size_t Size, std::size_t Align>
+    struct _storable : std::integral_constant<bool, !std::is_abstract<V>::value && sizeof(V) <= Size && alignof(V) <= Align
+                                                 && std::is_copy_constructible<V>::value && std::is_nothrow_move_constructible<V>::value
+                                                 && _static_downcast<Root, V>::value && !_is_plugin<V>::value>
+    {
+    };
+
+    // The operations of each class of L ({ nullptr, ... } when the class cannot be stored) followed by { nullptr, ... }
+    template<typename Root, std::size_t Size, std::size_t Align, typename L>
+    struct _value_table;
+
+    template<typename Root, std::size_t Size, std::size_t Align, typename... C>
+    struct _value_table<Root, Size, Align, type_list<C...>>
+    {
+        template<typename V>
+        static void copy(void * where, const Root & r)
+            {
+                construct<V>(where, static_cast<const V &>(r));
+            }
+
+        template<typename V>
+        static void move(void * where, Root & r)
+            {
+                construct<V>(where, std::move(static_cast<V &>(r)));
+            }
+
+        template<typename V>
+        static void destroy(Root & r)
+            {
+                static_cast<V &>(r).~V();
+            }
+
+        template<typename V>
+        constexpr static _value_ops<Root> entry(std::true_type) noexcept
+            {
+                return _value_ops<Root> { &copy<V>, &move<V>, &destroy<V> };
+            }
+
+        template<typename V>
+        constexpr static _value_ops<Root> entry(std::false_type) noexcept
+            {
+                return _value_ops<Root> { nullptr, nullptr, nullptr };
+            }
+
+        constexpr static _value_ops<Root> table[sizeof...(C) + 1] = { entry<C>(_storable<Root, C, Size, Align>())..., _value_ops<Root> { nullptr, nullptr, nullptr } };
+    };
+
+    template<typename Root, std::size_t Size, std::size_t Align, typename... C>
+    constexpr _value_ops<Root> _value_table<Root, Size, Align, type_list<C...>>::table[sizeof...(C) + 1];
+
+    /**
+     * An object of the hierarchy of the root class Root stored in place (in MaxSize bytes aligned on MaxAlign):
+     * a std::vector<poly_value<A, 64>> is contiguous and doesn't allocate an object for each element.
+     * The id of the object is the only discriminator: the type tests read it as fcast does,
+     * and the copy, the move and the destruction are found in a table indexed by the dense index of the id
+     * (so the classes need no virtual clone nor a virtual destructor).
+     *
+     * A poly_value always holds an object (a moved-from poly_value holds the moved-from object).
+     * The stored classes must be concrete, copyable, have a nothrow move constructor and not derive from Root
+     * through a virtual base; the Root subobject must be at the beginning of the object (Root is the first base class
+     * having data members). The plugin classes cannot be stored.
+     */
+    template<typename Root, std::size_t MaxSize, std::size_t MaxAlign = alignof(std::max_align_t)>
+    class poly_value
+    {
+        typedef typename _dense<Root>::fcast fcast;
+        typedef typename _dense<Root>::classes classes;
+        typedef _value_table<Root, MaxSize, MaxAlign, classes> table;
+
+        typename std::aligned_storage<MaxSize, MaxAlign>::type storage;
+
+    public:
+
+        typedef typename fcast::word_type word_type;
+
+        /**
+         * Hold a default constructed Root
+         */
+        poly_value()
+            {
+                _construct<Root>();
+            }
+
+        /**
+         * Hold a copy of v (or v moved) as a V
+         */
+        template<typename T, typename V = typename std::decay<T>::type, typename = typename std::enable_if<std::is_base_of<Root, V>::value>::type>
+        poly_value(T && v)
+            {
+                _construct<V>(std::forward<T>(v));
+            }
+
+        poly_value(const poly_value & v)
+            {
+                _ops(v.get()).copy(&storage, *v.get());
+            }
+
+        poly_value(poly_value && v) noexcept
+            {
+                _ops(v.get()).move(&storage, *v.get());
+            }
+
+        ~poly_value()
+            {
+                _destroy();
+            }
+
+        poly_value & operator=(const poly_value & v)
+            {
+                if (this != &v)
+                {
+                    poly_value copy(v);
+                    *this = std::move(copy);
+                }
+
+                return *this;
+            }
+
+        poly_value & operator=(poly_value && v) noexcept
+            {
+                if (this != &v)
+                {
+                    _destroy();
+                    _ops(v.get()).move(&storage, *v.get());
+                }
+
+                return *this;
+            }
+
+        /**
+         * @return a poly_value holding a V built from args
+         */
+        template<typename V, typename... Args>
+        static poly_value make(Args &&... args)
+            {
+                return poly_value(_type<V>(), std::forward<Args>(args)...);
+            }
+
+        /**
+         * Replace the object with a V built from args
+         * (when the constructor can throw, the V is built aside first so the poly_value is not changed by an exception)
+         * @return the new object
+         */
+        template<typename V, typename... Args>
+        V & emplace(Args &&... args)
+            {
+                return _emplace<V>(std::integral_constant<bool, std::is_nothrow_constructible<V, Args...>::value>(), std::forward<Args>(args)...);
+            }
+
+        Root * get() noexcept
+            {
+                return reinterpret_cast<Root *>(&storage);
+            }
+
+        const Root * get() const noexcept
+            {
+                return reinterpret_cast<const Root *>(&storage);
+            }
+
+        Root & operator*() noexcept
+            {
+                return *get();
+            }
+
+        const Root & operator*() const noexcept
+            {
+                return *get();
+            }
+
+        Root * operator->() noexcept
+            {
+                return get();
+            }
+
+        const Root * operator->() const noexcept
+            {
+                return get();
+            }
+
+        /**
+         * @return the id of the object
+         */
+        word_type id() const noexcept
+            {
+                return static_cast<word_type>(static_cast<const fcast *>(get())->_fcast_id);
+            }
+
+        /**
+         * @return true if the object is an instance of V
+         */
+        template<typename V>
+        bool instanceof() const noexcept(!_is_plugin<V>::value)
+            {
+                return fcast::template instanceof<V>(get());
+            }
+
+        /**
+         * @return true if the underlying type of the object is V
+         */
+        template<typename V>
+        bool same() const noexcept(!_is_plugin<V>::value)
+            {
+                return fcast::template same<V>(get());
+            }
+
+        /**
+         * @return the object cast to a V * or nullptr if it is not an instance of V
+         */
+        template<typename V>
+        V * cast() noexcept
+            {
+                return fcast::template cast<V>(get());
+            }
+
+        template<typename V>
+        const V * cast() const noexcept
+            {
+                return const_cast<poly_value *>(this)->template cast<V>();
+            }
+
+    private:
+
+        template<typename V>
+        struct _type { };
+
+        template<typename V, typename... Args>
+        poly_value(_type<V>, Args &&... args)
+            {
+                _construct<V>(std::forward<Args>(args)...);
+            }
+
+        static const _value_ops<Root> & _ops(const Root * r) noexcept
+            {
+                return table::table[_id_index<fcast, classes>::get(static_cast<const fcast *>(r)->_fcast_id)];
+            }
+
+        void _destroy() noexcept
+            {
+                _ops(get()).destroy(*get());
+            }
+
+        template<typename V, typename... Args>
+        V & _construct(Args &&... args)
+            {
+                _check<V>();
+
+                return *construct<V>(&storage, std::forward<Args>(args)...);
+            }
+
+        template<typename V>
+        void _check()
+            {
+                // the operations are found with the id: the class must be in the table
+                static_assert(_position<V, classes>::value < classes::size, "The class is not registered in the hierarchy of the root class");
+                static_assert(sizeof(V) <= MaxSize && alignof(V) <= MaxAlign, "The class doesn't fit in the storage of the poly_value");
+                static_assert(std::is_copy_constructible<V>::value && std::is_nothrow_move_constructible<V>::value, "The class must be copyable and have a nothrow move constructor");
+                static_assert(_static_downcast<Root, V>::value, "The class cannot derive from the root class through a virtual base");
+                static_assert(!_is_plugin<V>::value, "A plugin class cannot be stored in a poly_value");
+
+                // the object is found from the address of its Root subobject: this is the only check which
+                // cannot be done at compile time (the offset of a base is not a constant expression)
+                if (static_cast<Root *>(reinterpret_cast<V *>(&storage)) != reinterpret_cast<Root *>(&storage))
+                {
+                    throw fastcast::bad_cast();
+                }
+            }
+
+        template<typename V, typename... Args>
+        V & _emplace(std::true_type, Args &&... args)
+            {
+                _check<V>();
+                _destroy();
+
+                return *construct<V>(&storage, std::forward<Args>(args)...);
+            }
+
+        template<typename V, typename... Args>
+        V & _emplace(std::false_type, Args &&... args)
+            {
+                _check<V>();
+
+                typename std::aligned_storage<sizeof(V), alignof(V)>::type aside;
+                V * const v = construct<V>(&aside, std::forward<Args>(args)...);
+                _destroy();
+                V & r = *construct<V>(&storage, std::move(*v));
+                v->~V();
+
+                return r;
+            }
+    };
+
+    /**
+     * @return true if the object held by v is an instance of V
+     */
+    template<typename V, typename Root, std::size_t MaxSize, std::size_t MaxAlign>
+    inline bool instanceof(const poly_value<Root, MaxSize, MaxAlign> & v) noexcept(!_is_plugin<V>::value)
+    {
+        return v.template instanceof<V>();
+    }
+
+    /**
+     * @return true if the underlying type of the object held by v is V
+     */
+    template<typename V, typename Root, std::size_t MaxSize, std::size_t MaxAlign>
+    inline bool same(const poly_value<Root, MaxSize, MaxAlign> & v) noexcept(!_is_plugin<V>::value)
+    {
+        return v.template same<V>();
+    }
+
+    /**
+     * @return a pointer to the object held by v as a V or nullptr if it is not an instance of V
+     */
+    template<typename V, typename Root, std::size_t MaxSize, std::size_t MaxAlign>
+    inline V * cast(poly_value<Root, MaxSize, MaxAlign> & v) noexcept
+    {
+        return v.template cast<V>();
+    }
+
+    template<typename V, typename Root, std::size_t MaxSize, std::size_t MaxAlign>
+    inline const V * cast(const poly_value<Root, MaxSize, MaxAlign> & v) noexcept
+    {
+        return v.template cast<V>();
+    }
+
+    /**
+     * Type switch on the object held by v (see fastcast::match)
+     */
+    template<typename Root, std::size_t MaxSize, std::size_t MaxAlign, typename... H>
+    inline typename _callable<typename std::decay<typename _first<H...>::type>::type>::result visit(poly_value<Root, MaxSize, MaxAlign> & v, H &&... handlers)
+    {
+        return match<Root>(*v, std::forward<H>(handlers)...);
+    }
+
+    template<typename Root, std::size_t MaxSize, std::size_t MaxAlign, typename... H>
+    inline typename _callable<typename std::decay<typename _first<H...>::type>::type>::result visit(const poly_value<Root, MaxSize, MaxAlign> & v, H &&... handlers)
+    {
+        return match<Root>(*v, std::forward<H>(handlers)...);
+    }
+
+} // namespace fastcast
+
+#endif // __FASTCAST_VALUE_HXX__
@@ -0,0 +1,124 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Representative casts compiled by run.sh: each function must stay short and without branch
+// (the expected maximal number of instructions is given in run.sh)
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using FcastA = fastcast::fcast<A, uint32_t>;
+using FcastD = fastcast::fcast<D, uint64_t>;
+
+/*
+ * A--B--E
+ * |  |
+ * C  F
+ *
+ * D--G (G also derives from C)
+ */
+
+struct A : public FcastA
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<E, F>> fcast_hierarchy;
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+};
+
+struct D : public FcastD
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<G>> fcast_hierarchy;
+    virtual ~D() { }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+};
+
+struct F : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+};
+
+struct G : public C, public D
+{
+    typedef fastcast::hierarchy<fastcast::parents<C, D>> fcast_hierarchy;
+};
+
+// V has children: a mask and a comparison
+extern "C" bool instanceof_inner(A * a)
+{
+    return FcastA::instanceof<B>(a);
+}
+
+// V is a leaf: an equality
+extern "C" bool instanceof_leaf(A * a)
+{
+    return FcastA::instanceof<E>(a);
+}
+
+// W derives from V: a constant
+extern "C" bool instanceof_base(E * e)
+{
+    return FcastA::instanceof<B>(e);
+}
+
+// V has two parents (the id of G in the hierarchy of D)
+extern "C" bool instanceof_parents(D * d)
+{
+    return FcastD::instanceof<G>(d);
+}
+
+extern "C" bool same_inner(A * a)
+{
+    return FcastA::same<B>(a);
+}
+
+extern "C" B * cast_inner(A * a)
+{
+    return FcastA::cast<B>(a);
+}
+
+extern "C" E * cast_leaf(A * a)
+{
+    return FcastA::cast<E>(a);
+}
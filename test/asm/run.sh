@@ -0,0 +1,48 @@
+#!/bin/sh
+# Compile the casts of casts.cpp at -O2 with each compiler (g++ by default, or the ones given in CXX)
+# and check the assembly of each function: no branch and at most the given number of instructions (ret included).
+# Only x86-64 is checked. The limits were measured with g++ 12 only: clang++ can be tried with CXX="g++ clang++",
+# but its output has not been checked against them.
+set -e
+DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT="$DIR/../.."
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+# function and maximal number of instructions
+CHECKS="instanceof_inner 6
+instanceof_leaf 4
+instanceof_base 2
+instanceof_parents 6
+same_inner 4
+cast_inner 8
+cast_leaf 7"
+
+fail=0
+for cxx in ${CXX:-g++}; do
+    if ! command -v "$cxx" > /dev/null 2>&1; then
+        echo "$cxx is not available"
+        continue
+    fi
+    case $($cxx -dumpmachine) in
+        x86_64*) ;;
+        *) echo "$cxx does not target x86-64"; continue ;;
+    esac
+
+    $cxx -std=c++11 -O2 -S -fno-asynchronous-unwind-tables -fno-exceptions -o "$OUT/casts.s" "$DIR/casts.cpp" -I"$ROOT"
+    echo "$CHECKS" | while read -r name max; do
+        # the instructions between the label of the function and its end
+        body=$(awk -v f="$name" '$0 == f ":" { on = 1; next } on && /^[^ \t]/ { on = 0 } on && /^[ \t]+[a-z]/ { print $1 }' "$OUT/casts.s" | sed '/^\./d')
+        count=$(echo "$body" | grep -c .)
+        branches=$(echo "$body" | grep -c '^j' || true)
+        if [ "$count" -eq 0 ] || [ "$count" -gt "$max" ] || [ "$branches" -ne 0 ]; then
+            echo "FAIL $cxx $name: $count instructions (at most $max), $branches branches"
+            echo "$body" | sed 's/^/    /'
+            exit 1
+        fi
+        echo "$cxx $name: $count instructions"
+    done || fail=1
+done
+
+[ $fail -eq 0 ] && echo "asm test passed"
+exit $fail
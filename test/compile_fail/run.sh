@@ -0,0 +1,26 @@
+#!/bin/sh
+# Compile each file of this directory and check that the compilation fails with the message given
+# in its "// expect: " line (the misuses which must be rejected at compile time).
+DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT="$DIR/../.."
+CXX=${CXX:-g++}
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+fail=0
+for f in "$DIR"/*.cpp; do
+    expect=$(sed -n 's|^// expect: ||p' "$f")
+    if $CXX -std=c++11 -fsyntax-only "$f" -I"$ROOT" > "$OUT/log" 2>&1; then
+        echo "FAIL $(basename "$f"): compiled"
+        fail=1
+    elif ! grep -qF "$expect" "$OUT/log"; then
+        echo "FAIL $(basename "$f"): no \"$expect\""
+        sed 's/^/    /' "$OUT/log" | head -20
+        fail=1
+    else
+        echo "$(basename "$f"): rejected"
+    fi
+done
+
+[ $fail -eq 0 ] && echo "compile_fail test passed"
+exit $fail
@@ -0,0 +1,89 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <dlfcn.h>
+#include <iostream>
+
+#include "plugin_hierarchy.hxx"
+
+struct plugin
+{
+    void * handle;
+    load_t load;
+    make_t make;
+    instanceof_t instanceof;
+
+    plugin(const char * path) : handle(dlopen(path, RTLD_NOW | RTLD_LOCAL))
+        {
+            if (!handle)
+            {
+                std::cerr << dlerror() << std::endl;
+            }
+            assert(handle);
+            load = reinterpret_cast<load_t>(dlsym(handle, "plugin_load"));
+            make = reinterpret_cast<make_t>(dlsym(handle, "plugin_make"));
+            instanceof = reinterpret_cast<instanceof_t>(dlsym(handle, "plugin_instanceof"));
+            assert(load && make && instanceof);
+        }
+};
+
+// plugin_host path/to/plugin_x.so path/to/plugin_y.so
+int main(int argc, char ** argv)
+{
+    assert(argc == 3);
+
+    plugin x(argv[1]);
+    plugin y(argv[2]);
+
+    // The two plugins share the slots of B
+    const unsigned int sx = x.load();
+    const unsigned int sy = y.load();
+    assert(sx != sy && sx < 4 && sy < 4);
+
+    A * a = new A;
+    A * b = new B;
+    A * c = new C;
+    A * px = x.make();
+    A * py = y.make();
+    a->set_id<A>();
+    b->set_id<B>();
+    c->set_id<C>();
+
+    assert(px->_fcast_id != py->_fcast_id);
+    assert(Fcast::instanceof<B>(px) && Fcast::instanceof<B>(py));
+    assert(Fcast::instanceof<A>(px) && !Fcast::instanceof<C>(px));
+    assert(x.instanceof(px) && !x.instanceof(py));
+    assert(y.instanceof(py) && !y.instanceof(px));
+    assert(!x.instanceof(a) && !x.instanceof(b) && !x.instanceof(c));
+    assert(!y.instanceof(a) && !y.instanceof(b) && !y.instanceof(c));
+
+    for (auto p : { a, b, c, px, py })
+    {
+        delete p;
+    }
+
+    return 0;
+}
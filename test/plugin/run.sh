@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build two plugins and a host which loads them with dlopen, then run the host
+# The host is built with -rdynamic so the plugins share its slot counters.
+set -e
+CXX=${CXX:-g++}
+DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT="$DIR/../.."
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+$CXX -Wall -std=c++11 -fPIC -shared -DPLUGIN_NAME=X -o "$OUT/plugin_x.so" "$DIR/plugin.cpp" -I"$ROOT"
+$CXX -Wall -std=c++11 -fPIC -shared -DPLUGIN_NAME=Y -o "$OUT/plugin_y.so" "$DIR/plugin.cpp" -I"$ROOT"
+$CXX -Wall -std=c++11 -rdynamic -o "$OUT/plugin_host" "$DIR/plugin_host.cpp" -I"$ROOT" -ldl
+"$OUT/plugin_host" "$OUT/plugin_x.so" "$OUT/plugin_y.so"
+echo "plugin test passed"
@@ -0,0 +1,205 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <vector>
+
+#include "fastcast_arena.hxx"
+
+// The classes don't derive from fastcast::fcast: the ids are in the slabs
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+
+/*
+  A->B,C
+  B->D
+  D->E,F
+*/
+
+int alive = 0;
+
+struct A
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    int a;
+
+    A() : a(1) { ++alive; }
+    virtual ~A() { --alive; }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { a = 2; }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    char big[1000];
+
+    C() { a = 3; }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F>> fcast_hierarchy;
+
+    D() { a = 4; }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { a = 5; }
+};
+
+struct Other
+{
+    double x;
+    virtual ~Other() { }
+};
+
+struct F : public Other, public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    explicit F(int n)
+        {
+            if (n == -2)
+            {
+                throw n;
+            }
+            a = n;
+        }
+};
+
+using Arena = fastcast::slab_arena<A, uint8_t, 4096>;
+
+// Check instanceof and same for x against all the classes
+template<typename X, typename... V>
+void check_one(A * x, fastcast::type_list<V...>)
+{
+    const bool instanceof[] = { Arena::instanceof<V>(x)... };
+    const bool derived[] = { std::is_base_of<V, X>::value... };
+    const bool same[] = { Arena::same<V>(x)... };
+    const bool is_same[] = { std::is_same<V, X>::value... };
+
+    for (std::size_t i = 0; i < sizeof...(V); ++i)
+    {
+        assert(instanceof[i] == derived[i]);
+        assert(same[i] == is_same[i]);
+    }
+}
+
+int main()
+{
+    static_assert(std::is_same<fastcast::id_type<A>::type, uint8_t>::value, "Bad id type");
+
+    {
+        Arena arena;
+        std::vector<A *> v;
+
+        // several slabs per class
+        for (int i = 0; i < 1000; ++i)
+        {
+            v.push_back(arena.make<A>());
+            v.push_back(arena.make<B>());
+            v.push_back(arena.make<C>());
+            v.push_back(arena.make<D>());
+            v.push_back(arena.make<E>());
+            v.push_back(arena.make<F>(i));
+        }
+        assert(alive == 6000);
+
+        for (std::size_t i = 0; i < v.size(); i += 6)
+        {
+            check_one<A>(v[i], fastcast::hierarchy_of<A>::type());
+            check_one<B>(v[i + 1], fastcast::hierarchy_of<A>::type());
+            check_one<C>(v[i + 2], fastcast::hierarchy_of<A>::type());
+            check_one<D>(v[i + 3], fastcast::hierarchy_of<A>::type());
+            check_one<E>(v[i + 4], fastcast::hierarchy_of<A>::type());
+            check_one<F>(v[i + 5], fastcast::hierarchy_of<A>::type());
+
+            assert(v[i + 2]->a == 3);
+            assert(Arena::cast<C>(v[i + 2]) == static_cast<C *>(v[i + 2]));
+            assert(Arena::cast<B>(v[i + 2]) == nullptr);
+            assert(Arena::cast<F>(v[i + 5])->a == static_cast<int>(i / 6));
+            assert(&Arena::cast<D>(*v[i + 5]) == static_cast<D *>(v[i + 5]));
+        }
+
+        // F is not at the beginning of its A base: destroy must find the object
+        F * f = Arena::cast<F>(v[5]);
+        assert(static_cast<void *>(f) != static_cast<void *>(v[5]));
+        arena.destroy(v[5]);
+        assert(alive == 5999);
+
+        // the freed slot is reused
+        F * g = arena.make<F>(-1);
+        assert(g == f);
+        assert(Arena::same<F>(static_cast<A *>(g)));
+        arena.destroy(g);
+
+        for (std::size_t i = 0; i < v.size(); ++i)
+        {
+            if (i != 5)
+            {
+                arena.destroy(v[i]);
+            }
+        }
+        assert(alive == 0);
+
+        // as delete, destroy does nothing with a null pointer
+        arena.destroy(static_cast<A *>(nullptr));
+        assert(alive == 0);
+
+        // a construction which throws gives the slot back
+        F * h = arena.make<F>(0);
+        arena.destroy(h);
+        bool thrown = false;
+        try
+        {
+            arena.make<F>(-2);
+        }
+        catch (int)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(alive == 0);
+        assert(arena.make<F>(0) == h);
+    }
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+using Fcast8 = fastcast::fcast<A, uint8_t>;
+
+struct A : public Fcast, public Fcast8
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); Fcast8::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); Fcast8::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); Fcast8::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); Fcast8::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); Fcast8::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); Fcast8::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); Fcast8::set_id<G>(); }
+};
+
+struct P;
+struct Q;
+struct Q1;
+struct Q2;
+
+using FcastP = fastcast::fcast<P, uint32_t>;
+
+/*
+ * P--Q--Q1
+ *    |
+ *    Q2
+ *
+ * Q derives from P through a virtual base: the offset of the id in a Q depends on the class of the object
+ */
+
+struct P : public FcastP
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<Q>> fcast_hierarchy;
+
+    P() { FcastP::set_id<P>(); }
+    virtual ~P() { }
+};
+
+struct Q : public virtual P
+{
+    typedef fastcast::hierarchy<P, fastcast::children<Q1, Q2>> fcast_hierarchy;
+
+    Q() { FcastP::set_id<Q>(); }
+};
+
+struct Q1 : public Q
+{
+    typedef fastcast::hierarchy<Q> fcast_hierarchy;
+    int q1[3];
+
+    Q1() : q1 { 1, 2, 3 } { FcastP::set_id<Q1>(); }
+};
+
+struct Q2 : public Q
+{
+    typedef fastcast::hierarchy<Q> fcast_hierarchy;
+    int q2[9];
+
+    Q2() : q2 { } { FcastP::set_id<Q2>(); }
+};
+
+A * make(int n)
+{
+    switch (n % 7)
+    {
+    case 0: return new A;
+    case 1: return new B;
+    case 2: return new C;
+    case 3: return new D;
+    case 4: return new E;
+    case 5: return new F;
+    default: return new G;
+    }
+}
+
+template<typename Fc, typename V, typename W>
+void check(const std::vector<W *> & v)
+{
+    const std::size_t n = v.size();
+    std::vector<uint64_t> mask((n + 63) / 64);
+    std::vector<V *> in(n);
+    std::vector<W *> out(n);
+    std::size_t expected = 0;
+
+    const std::size_t count = Fc::template instanceof_n<V>(v.data(), n, mask.data());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const bool b = Fc::template instanceof<V>(v[i]);
+        assert(b == (((mask[i / 64] >> (i % 64)) & 1) != 0));
+        expected += b;
+    }
+    assert(count == expected);
+
+    assert(Fc::template filter<V>(v.data(), n, in.data()) == expected);
+    for (std::size_t i = 0, j = 0; i < n; ++i)
+    {
+        if (Fc::template instanceof<V>(v[i]))
+        {
+            assert(in[j++] == Fc::template cast<V>(v[i]));
+        }
+    }
+
+    assert(Fc::template partition<V>(v.data(), n, in.data(), out.data()) == expected);
+    for (std::size_t i = 0, j = 0, k = 0; i < n; ++i)
+    {
+        if (Fc::template instanceof<V>(v[i]))
+        {
+            assert(in[j++] == Fc::template cast<V>(v[i]));
+        }
+        else
+        {
+            assert(out[k++] == v[i]);
+        }
+    }
+}
+
+template<typename Fc>
+void check_all(const std::vector<A *> & v)
+{
+    check<Fc, A>(v);
+    check<Fc, B>(v);
+    check<Fc, C>(v);
+    check<Fc, D>(v);
+    check<Fc, E>(v);
+    check<Fc, F>(v);
+    check<Fc, G>(v);
+}
+
+int main()
+{
+    std::srand(42);
+
+    // Several sizes to exercise the vectorized blocks and the scalar tails
+    for (std::size_t n : { 0, 1, 7, 8, 15, 16, 17, 63, 64, 65, 1000 })
+    {
+        std::vector<A *> v;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            v.push_back(make(std::rand()));
+        }
+
+        check_all<Fcast>(v);
+        check_all<Fcast8>(v);
+
+        std::vector<Q *> q;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            q.push_back(i % 3 ? static_cast<Q *>(new Q1) : (i % 2 ? static_cast<Q *>(new Q2) : new Q));
+        }
+
+        check<FcastP, Q>(q);
+        check<FcastP, Q1>(q);
+        check<FcastP, Q2>(q);
+
+        // the instances of Q are found from a virtual base
+        std::vector<P *> p(q.begin(), q.end());
+        check<FcastP, Q>(p);
+        check<FcastP, Q1>(p);
+
+        for (auto p : v)
+        {
+            delete p;
+        }
+        for (auto p : q)
+        {
+            delete p;
+        }
+    }
+
+    return 0;
+}
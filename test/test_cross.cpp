@@ -65,7 +65,7 @@ struct D : public FcastD
 
 struct E : public D
 {
-    typedef fastcast::hierarchy<D, fastcast::children<C>> fcast_hierarchy;
+    typedef fastcast::hierarchy<D, fastcast::children<G>> fcast_hierarchy;
     E() { FcastD::set_id<E>(); }
 };
 
@@ -119,5 +119,35 @@ int main()
     assert(FcastA::instanceof<H>(static_cast<A *>(&h)));
     assert(FcastD::instanceof<H>(static_cast<D *>(&h)));
 
+    // sideways casts between the two roots
+    A * ga = static_cast<A *>(&g);
+    D * gd = static_cast<D *>(&g);
+    A * ha = static_cast<A *>(&h);
+    assert(fastcast::cross_cast<D>(ga) == gd);
+    assert(fastcast::cross_cast<E>(ga) == static_cast<E *>(&g));
+    assert(fastcast::cross_cast<A>(gd) == ga);
+    assert(fastcast::cross_cast<C>(gd) == static_cast<C *>(&g));
+    assert(fastcast::cross_cast<G>(gd) == &g);
+    assert(fastcast::cross_cast<D>(ha) == static_cast<D *>(&h));
+    assert(fastcast::cross_cast<H>(static_cast<E *>(&h)) == &h);
+    assert(fastcast::cross_cast<H>(ga) == nullptr);
+    assert(fastcast::cross_cast<D>(static_cast<A *>(&c)) == nullptr);
+    assert(fastcast::cross_cast<F>(gd) == nullptr);
+    assert(fastcast::cross_cast<A>(static_cast<D *>(&f)) == nullptr);
+    assert(fastcast::cross_cast<D>(static_cast<A *>(nullptr)) == nullptr);
+    assert(fastcast::cross_cast<C>(&h) == static_cast<C *>(&h));
+    assert(&fastcast::cross_cast<E>(*ga) == static_cast<E *>(&g));
+
+    bool thrown = false;
+    try
+    {
+        fastcast::cross_cast<D>(static_cast<A &>(b));
+    }
+    catch (const fastcast::bad_cast &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
     return 0;
 }
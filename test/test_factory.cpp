@@ -0,0 +1,160 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <string>
+
+#include "fastcast_arena.hxx"
+#include "fastcast_factory.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+
+using Fcast = fastcast::fcast<A, uint8_t>;
+
+/*
+ * A--B--D
+ * |  |
+ * |  E
+ * C
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    virtual ~A() { }
+    virtual int value() const = 0;
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D, E>> fcast_hierarchy;
+    typedef fastcast::tag<B, 1> fcast_tag;
+    int b;
+    B(int _b = 2) : b(_b) { }
+    int value() const { return b; }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    typedef fastcast::tag<C, fastcast::tag_hash("test.C")> fcast_tag;
+    std::string c;
+    C() : c("c") { }
+    C(const std::string & _c) : c(_c) { }
+    int value() const { return static_cast<int>(c.size()); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    typedef fastcast::tag<D, 4095> fcast_tag;
+    D() : B(4) { }
+    int value() const { return 4; }
+};
+
+// E inherits the fcast_tag of B, so it has no tag
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() : B(5) { }
+};
+
+// The same classes with colliding tags
+struct X;
+struct Y;
+struct Z;
+
+using FcastX = fastcast::fcast<X, uint8_t>;
+
+struct X : public FcastX
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<Y, Z>> fcast_hierarchy;
+};
+
+struct Y : public X
+{
+    typedef fastcast::hierarchy<X> fcast_hierarchy;
+    typedef fastcast::tag<Y, 7> fcast_tag;
+};
+
+struct Z : public X
+{
+    typedef fastcast::hierarchy<X> fcast_hierarchy;
+    typedef fastcast::tag<Z, 7> fcast_tag;
+};
+
+using Factory = fastcast::factory<A>;
+
+int main()
+{
+    static_assert(fastcast::tag_of<A>::value == 0 && fastcast::tag_of<B>::value == 1 && fastcast::tag_of<E>::value == 0, "Invalid tags");
+    static_assert(Factory::tag<C>() == fastcast::tag_hash("test.C"), "Invalid tag");
+    static_assert(fastcast::tag_hash("") == 2166136261u && fastcast::tag_hash("a") == 0xE40C292Cu, "Invalid hash");
+    static_assert(fastcast::unique_tags<A>::value && !fastcast::unique_tags<X>::value, "The collision is not detected");
+    static_assert(Factory::max_size == sizeof(C) && Factory::max_align == alignof(C), "Invalid storage size");
+
+    assert(Factory::contains(1) && Factory::contains(4095) && Factory::contains(Factory::tag<C>()));
+    assert(!Factory::contains(0) && !Factory::contains(2) && !Factory::contains(4096));
+
+    A * b = Factory::make(Factory::tag<B>());
+    assert(b && Fcast::same<B>(b) && b->value() == 2);
+    A * b7 = Factory::make(1, 7);
+    assert(b7 && Fcast::same<B>(b7) && b7->value() == 7);
+    A * c = Factory::make(Factory::tag<C>(), std::string("abc"));
+    assert(c && Fcast::same<C>(c) && c->value() == 3);
+    A * d = Factory::make(4095);
+    assert(d && Fcast::same<D>(d) && Fcast::instanceof<B>(d) && d->value() == 4);
+
+    // unknown tags and classes which cannot be built from the arguments
+    assert(!Factory::make(12345));
+    assert(!Factory::make(0));
+    assert(!Factory::make(4095, 3));
+    assert(!Factory::make(Factory::tag<C>(), 1.5, 2));
+
+    delete b;
+    delete b7;
+    delete c;
+    delete d;
+
+    // in a caller-supplied storage
+    alignas(Factory::max_align) char storage[Factory::max_size];
+    A * s = Factory::construct(storage, Factory::tag<C>(), std::string("abcd"));
+    assert(static_cast<void *>(s) == static_cast<void *>(storage) && Fcast::same<C>(s) && s->value() == 4);
+    s->~A();
+    assert(!Factory::construct(storage, 3));
+
+    // in an arena
+    fastcast::slab_arena<A> arena;
+    A * a = Factory::make_in(arena, 4095);
+    assert(a && fastcast::slab_arena<A>::same<D>(a) && Fcast::same<D>(a));
+    arena.destroy(a);
+    assert(!Factory::make_in(arena, 99));
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A small cache to test the case where it is full
+#define FASTCAST_HYBRID_CACHE_SIZE 4
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "fastcast_hybrid.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+
+using Fcast = fastcast::fcast<A, uint8_t>;
+
+/*
+ * A--B--D
+ * |
+ * C
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+// Classes which are not in the hierarchy
+struct Named
+{
+    int n;
+    Named() : n(7) { }
+    virtual ~Named() { }
+};
+
+struct X : public B, public Named { };
+struct Y : public D { };
+struct Z : public C, public Named { };
+
+template<int I>
+struct Many : public A, public Named { };
+
+// hybrid_cast gives the same pointer as dynamic_cast
+template<typename V, typename W>
+void check(W * w)
+{
+    assert(fastcast::hybrid_cast<V>(w) == dynamic_cast<V *>(w));
+}
+
+template<typename W>
+void check_all(W * w)
+{
+    check<A>(w);
+    check<B>(w);
+    check<C>(w);
+    check<D>(w);
+    check<X>(w);
+    check<Y>(w);
+    check<Z>(w);
+    check<Named>(w);
+}
+
+int main()
+{
+    static_assert(fastcast::_hybrid_ids<D, A>::value && fastcast::_hybrid_ids<D, X>::value, "The ids must be used");
+    static_assert(!fastcast::_hybrid_ids<X, A>::value && !fastcast::_hybrid_ids<Named, A>::value && !fastcast::_hybrid_ids<D, Named>::value, "The ids cannot be used");
+
+    A a;
+    B b;
+    C c;
+    D d;
+    X x;
+    Y y;
+    Z z;
+    A * all[] = { &a, &b, &c, &d, &x, &y, &z };
+
+    assert(fastcast::hybrid_cast<D>(static_cast<A *>(nullptr)) == nullptr);
+    assert(fastcast::hybrid_cast<Named>(static_cast<A *>(nullptr)) == nullptr);
+
+    // twice: the second time the results are read in the cache
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        for (auto p : all)
+        {
+            check_all(p);
+        }
+        check_all(static_cast<Named *>(&x));
+        check_all(static_cast<Named *>(&z));
+        check_all(static_cast<B *>(&x));
+    }
+    assert(fastcast::hybrid_cast<Named>(static_cast<A *>(&z))->n == 7);
+    assert(&fastcast::hybrid_cast<X>(static_cast<Named &>(x)) == &x);
+
+    bool thrown = false;
+    try
+    {
+        fastcast::hybrid_cast<Z>(static_cast<A &>(x));
+    }
+    catch (const fastcast::bad_cast &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // more virtual tables than entries in the cache, from several threads
+    Many<0> m0;
+    Many<1> m1;
+    Many<2> m2;
+    Many<3> m3;
+    Many<4> m4;
+    Many<5> m5;
+    A * many[] = { &m0, &m1, &m2, &m3, &m4, &m5, &x, &z, &a };
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&many]()
+            {
+                for (unsigned int i = 0; i < 1000; ++i)
+                {
+                    for (auto p : many)
+                    {
+                        assert(fastcast::hybrid_cast<Named>(p) == dynamic_cast<Named *>(p));
+                        assert(fastcast::hybrid_cast<Many<3>>(p) == dynamic_cast<Many<3> *>(p));
+                    }
+                }
+            });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    return 0;
+}
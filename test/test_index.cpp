@@ -0,0 +1,199 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "fastcast_index.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+
+using Fcast = fastcast::fcast<A, uint16_t>;
+
+/*
+ * A--B--D--G
+ * |  |
+ * |  E
+ * |  |
+ * |  F
+ * C
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<fastcast::weight<D, 10>, E, F>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<G>> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    G() { Fcast::set_id<G>(); }
+};
+
+// Check that the index and the sorted array give the instances of V
+template<typename V>
+void check(const std::vector<A *> & objects, const fastcast::type_sorted_index<A> & index, std::vector<A *> & sorted)
+{
+    std::size_t n = 0;
+    for (auto o : objects)
+    {
+        n += Fcast::instanceof<V>(o);
+    }
+
+    assert(index.count<V>() == n);
+    std::size_t visited = 0;
+    index.for_each<V>([&](V & v) { assert(Fcast::instanceof<V>(&v)); ++visited; });
+    assert(visited == n);
+
+    const std::pair<A **, A **> r = fastcast::type_range<V>(sorted.data(), sorted.data() + sorted.size());
+    assert(static_cast<std::size_t>(r.second - r.first) == n);
+    for (A ** p = r.first; p != r.second; ++p)
+    {
+        assert(Fcast::instanceof<V>(*p));
+    }
+}
+
+void check_all(const std::vector<A *> & objects, const fastcast::type_sorted_index<A> & index)
+{
+    std::vector<A *> sorted(objects);
+    fastcast::sort_by_type(sorted.data(), sorted.data() + sorted.size());
+
+    assert(index.size() == objects.size());
+    check<A>(objects, index, sorted);
+    check<B>(objects, index, sorted);
+    check<C>(objects, index, sorted);
+    check<D>(objects, index, sorted);
+    check<E>(objects, index, sorted);
+    check<F>(objects, index, sorted);
+    check<G>(objects, index, sorted);
+}
+
+int main()
+{
+    assert(fastcast::reverse_bits(uint64_t(1)) == uint64_t(1) << 63);
+    assert(fastcast::reverse_bits(uint64_t(0x0123456789ABCDEFull)) == 0xF7B3D591E6A2C480ull);
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128_t;
+    assert(fastcast::reverse_bits(uint128_t(1)) == uint128_t(1) << 127);
+    assert(fastcast::reverse_bits(uint128_t(6) << 64) == uint128_t(3) << 61);
+#endif
+
+    std::vector<A *> objects;
+    fastcast::type_sorted_index<A> index;
+    assert(index.empty() && index.count<A>() == 0);
+
+    std::srand(0);
+    for (unsigned int i = 0; i < 1000; ++i)
+    {
+        A * o;
+        switch (std::rand() % 7)
+        {
+        case 0: o = new A; break;
+        case 1: o = new B; break;
+        case 2: o = new C; break;
+        case 3: o = new D; break;
+        case 4: o = new E; break;
+        case 5: o = new F; break;
+        default: o = new G; break;
+        }
+        objects.push_back(o);
+        index.insert(o);
+    }
+    check_all(objects, index);
+
+    // erase one object out of three
+    std::vector<A *> kept;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        if (i % 3)
+        {
+            kept.push_back(objects[i]);
+        }
+        else
+        {
+            assert(index.erase(objects[i]));
+            assert(!index.erase(objects[i]));
+            delete objects[i];
+        }
+    }
+    check_all(kept, index);
+
+    // insert again
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+        A * o = i % 2 ? static_cast<A *>(new G) : static_cast<A *>(new C);
+        kept.push_back(o);
+        index.insert(o);
+    }
+    check_all(kept, index);
+
+    for (auto o : kept)
+    {
+        delete o;
+    }
+    index.clear();
+    assert(index.empty() && index.count<B>() == 0);
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <cstring>
+
+#include "fastcast.hxx"
+
+// The hierarchy of test_cross.cpp but the constructors don't set the ids
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using FcastA = fastcast::fcast<A, uint8_t>;
+using FcastD = fastcast::fcast<D, uint8_t>;
+
+struct A : public FcastA
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    int a;
+    A(int _a = 0) : a(_a) { }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+};
+
+struct D : public FcastD
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<E, F>> fcast_hierarchy;
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<G>> fcast_hierarchy;
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+};
+
+struct G : public C, public E
+{
+    typedef fastcast::hierarchy<fastcast::parents<C, E>, fastcast::children<H>> fcast_hierarchy;
+    G(int _a = 0) { a = _a; }
+};
+
+struct H : public G
+{
+    typedef fastcast::hierarchy<G> fcast_hierarchy;
+    H(int _a) : G(_a) { }
+};
+
+static_assert(std::is_same<fastcast::_roots<B>::type, fastcast::type_list<A>>::value, "Invalid roots");
+static_assert(std::is_same<fastcast::_roots<H>::type, fastcast::type_list<A, D>>::value, "Invalid roots");
+
+int main()
+{
+    alignas(H) unsigned char buffer[sizeof(H)];
+    std::memset(buffer, 0xff, sizeof(buffer));
+
+    B * b = fastcast::make<B>();
+    F * f = fastcast::make<F>();
+    G * g = fastcast::make<G>(3);
+    H * h = fastcast::construct<H>(buffer, 4);
+    fastcast::concrete<C> c;
+    fastcast::concrete<H> hh(5);
+
+    assert(FcastA::same<B>(static_cast<A *>(b)));
+    assert(!FcastA::instanceof<C>(static_cast<A *>(b)));
+    assert(FcastD::same<F>(static_cast<D *>(f)));
+    assert(!FcastD::instanceof<E>(static_cast<D *>(f)));
+
+    assert(FcastA::same<G>(static_cast<A *>(g)));
+    assert(FcastD::same<G>(static_cast<D *>(g)));
+    assert(FcastA::cast<C>(static_cast<A *>(g)) == g);
+    assert(FcastD::cast<E>(static_cast<D *>(g)) == g);
+    assert(g->a == 3);
+
+    assert(FcastA::same<H>(static_cast<A *>(h)));
+    assert(FcastD::same<H>(static_cast<D *>(h)));
+    assert(FcastA::instanceof<G>(static_cast<A *>(h)));
+    assert(FcastD::instanceof<G>(static_cast<D *>(h)));
+    assert(h->a == 4);
+
+    assert(FcastA::same<C>(static_cast<A *>(&c)));
+    assert(!FcastA::instanceof<G>(static_cast<A *>(&c)));
+    assert(FcastA::same<H>(static_cast<A *>(&hh)));
+    assert(FcastD::same<H>(static_cast<D *>(&hh)));
+    assert(hh.a == 5);
+
+    h->~H();
+    delete g;
+    delete f;
+    delete b;
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<E, F, G>> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<H>> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+struct H : public E
+{
+    typedef fastcast::hierarchy<E> fcast_hierarchy;
+
+    H() { Fcast::set_id<H>(); }
+};
+
+int which(A & a)
+{
+    return fastcast::match<A>(a,
+                              [](G &) { return 7; },
+                              [](B &) { return 2; },
+                              [](E &) { return 5; },
+                              [](const C &) { return 3; });
+}
+
+int which_const(const A * a)
+{
+    return fastcast::match<A>(a,
+                              [](const D &) { return 4; },
+                              [](const A &) { return 1; });
+}
+
+int main()
+{
+    A a;
+    B b;
+    C c;
+    D d;
+    E e;
+    F f;
+    G g;
+    H h;
+
+    // prefix order
+    static_assert(std::is_same<fastcast::hierarchy_of<A>::type, fastcast::type_list<A, B, D, E, H, F, G, C>>::value, "Bad hierarchy");
+
+    // exact handler or the one of the closest base
+    assert(which(a) == 0);
+    assert(which(b) == 2);
+    assert(which(c) == 3);
+    assert(which(d) == 2);
+    assert(which(e) == 5);
+    assert(which(f) == 2);
+    assert(which(g) == 7);
+    assert(which(h) == 5);
+
+    assert(which_const(&a) == 1);
+    assert(which_const(&b) == 1);
+    assert(which_const(&c) == 1);
+    assert(which_const(&d) == 4);
+    assert(which_const(&h) == 4);
+
+    // static type other than the root and void handlers
+    int n = 0;
+    fastcast::match<A>(static_cast<D &>(h), [&n](E & x) { n = Fcast::same<H>(&x) ? 1 : 2; }, [&n](D &) { n = 3; });
+    assert(n == 1);
+    fastcast::match<A>(static_cast<D &>(g), [&n](E &) { n = 1; }, [&n](D &) { n = 3; });
+    assert(n == 3);
+
+    // the handler receives the right object
+    B * p = nullptr;
+    fastcast::match<A>(static_cast<A &>(e), [&p](B & x) { p = &x; });
+    assert(p == &e);
+
+    // a matcher keeps its handlers
+    int calls = 0;
+    auto m = fastcast::make_matcher<A>([&calls](D &) { return ++calls; }, [](C &) { return -1; });
+    assert(m(static_cast<A &>(h)) == 1);
+    assert(m(&g) == 2);
+    assert(m(&c) == -1);
+    assert(m(&b) == 0);
+    assert(calls == 2);
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <string>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct X;
+struct Y;
+
+using Fcast = fastcast::fcast<A, uint8_t>;
+using FcastX = fastcast::fcast<X, uint8_t>;
+
+/*
+ * A--B--D
+ * |
+ * C
+ *
+ * X--Y
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct X : public FcastX
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<Y>> fcast_hierarchy;
+    X() { FcastX::set_id<X>(); }
+};
+
+struct Y : public X
+{
+    typedef fastcast::hierarchy<X> fcast_hierarchy;
+    Y() { FcastX::set_id<Y>(); }
+};
+
+int main()
+{
+    A a;
+    B b;
+    C c;
+    D d;
+    X x;
+    Y y;
+    A * all[] = { &a, &b, &c, &d };
+
+    // The dense indices are the positions in prefix order
+    static_assert(fastcast::dense_size<A>::value == 4, "Invalid dense size");
+    static_assert(fastcast::dense_index_of<A, A>::value == 0 && fastcast::dense_index_of<A, B>::value == 1, "Invalid dense index");
+    static_assert(fastcast::dense_index_of<A, D>::value == 2 && fastcast::dense_index_of<A, C>::value == 3, "Invalid dense index");
+    assert(fastcast::dense_index(a) == 0);
+    assert(fastcast::dense_index(static_cast<A *>(&b)) == 1);
+    assert(fastcast::dense_index(static_cast<A &>(d)) == 2);
+    assert(fastcast::dense_index(static_cast<A &>(c)) == 3);
+    assert(fastcast::dense_index(static_cast<X &>(y)) == 1);
+
+    auto m = fastcast::make_multimethod<int(A &, A &)>([](B &, A &) { return 1; },
+                                                      [](B &, C &) { return 2; },
+                                                      [](A &, A &) { return 3; },
+                                                      [](D &, D &) { return 4; },
+                                                      [](A &, B &) { return 5; });
+
+    // The expected handlers for all the pairs (first argument in the rows)
+    const int expected[4][4] = {
+        { 3, 5, 5, 3 },     // A with A, B, D, C
+        { 1, 1, 1, 2 },     // B: (B, A) is more specific than (A, B)
+        { 1, 1, 4, 2 },     // D
+        { 3, 5, 5, 3 },     // C
+    };
+    for (auto p : all)
+    {
+        for (auto q : all)
+        {
+            assert(m(*p, *q) == expected[fastcast::dense_index(p)][fastcast::dense_index(q)]);
+        }
+    }
+
+    // The arguments can be in different hierarchies and there is a default value when no handler applies
+    auto n = fastcast::make_multimethod<std::string(const A &, const X &, const A &)>([](const B &, const Y &, const A &) { return std::string("BYA"); },
+                                                                                     [](const A &, const X &, const C &) { return std::string("AXC"); });
+    assert(n(b, y, a) == "BYA");
+    assert(n(d, y, d) == "BYA");
+    assert(n(b, x, c) == "AXC");
+    assert(n(b, y, c) == "BYA");
+    assert(n(a, y, b) == "");
+
+    return 0;
+}
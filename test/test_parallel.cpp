@@ -0,0 +1,202 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "fastcast_parallel.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+
+/*
+ * A--B--D--F
+ * |  |
+ * |  E
+ * C
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D, E>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<F>> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    F() { Fcast::set_id<F>(); }
+};
+
+// Check that the bucket is the list of the objects selected by keep (in the same order)
+template<typename Buckets, typename K>
+void check_bucket(const Buckets & buckets, std::size_t i, const std::vector<A *> & objects, K keep)
+{
+    const std::pair<A * const *, A * const *> r = buckets.bucket(i);
+    A * const * p = r.first;
+    for (auto o : objects)
+    {
+        if (keep(o))
+        {
+            assert(p != r.second && *p == o);
+            ++p;
+        }
+    }
+    assert(p == r.second);
+}
+
+template<typename V>
+void check_exact(const fastcast::type_buckets<A> & buckets, const std::vector<A *> & objects)
+{
+    check_bucket(buckets, fastcast::dense_index_of<A, V>::value, objects, [](A * o) { return Fcast::same<V>(o); });
+
+    std::size_t n = 0;
+    buckets.for_each<V>([&](V & v) { assert(Fcast::same<V>(&v)); ++n; });
+    assert(n == static_cast<std::size_t>(buckets.bucket<V>().second - buckets.bucket<V>().first));
+}
+
+void check(const std::vector<A *> & objects, fastcast::work_stealing_pool & pool)
+{
+    const fastcast::type_buckets<A> exact = fastcast::bucket_by_type(objects.data(), objects.data() + objects.size(), pool);
+    static_assert(fastcast::type_buckets<A>::count == 7, "A bucket for each class and one for the unknown classes");
+    assert(exact.size() == objects.size());
+    check_exact<A>(exact, objects);
+    check_exact<B>(exact, objects);
+    check_exact<C>(exact, objects);
+    check_exact<D>(exact, objects);
+    check_exact<E>(exact, objects);
+    check_exact<F>(exact, objects);
+    assert(exact.others().first == exact.others().second);
+
+    // D before B: the instances of D go in the first bucket and the other instances of B in the second one
+    const fastcast::type_buckets<A, D, B> subtrees = fastcast::bucket_by_type<A, D, B>(objects.data(), objects.data() + objects.size(), pool);
+    static_assert(fastcast::type_buckets<A, D, B>::count == 3, "A bucket for D, for B and for the others");
+    check_bucket(subtrees, 0, objects, [](A * o) { return Fcast::instanceof<D>(o); });
+    check_bucket(subtrees, 1, objects, [](A * o) { return Fcast::instanceof<B>(o) && !Fcast::instanceof<D>(o); });
+    check_bucket(subtrees, 2, objects, [](A * o) { return !Fcast::instanceof<B>(o); });
+    assert(subtrees.bucket<B>().first == subtrees.bucket(1).first);
+}
+
+A * make(int k)
+{
+    switch (k)
+    {
+    case 0: return new A;
+    case 1: return new B;
+    case 2: return new C;
+    case 3: return new D;
+    case 4: return new E;
+    default: return new F;
+    }
+}
+
+int main()
+{
+    // each task runs once, and the pool can run several jobs
+    for (unsigned int workers : { 1u, 2u, 4u, 7u })
+    {
+        fastcast::work_stealing_pool pool(workers);
+        assert(pool.size() == workers);
+        for (std::size_t n : { std::size_t(0), std::size_t(1), std::size_t(3), std::size_t(1000) })
+        {
+            std::vector<std::atomic<unsigned int>> runs(n);
+            for (auto & r : runs)
+            {
+                r = 0;
+            }
+            pool.run(n, [&](std::size_t i, unsigned int w)
+                     {
+                         assert(w < workers);
+                         // the tasks are uneven so the workers steal
+                         if (i % 7 == 0)
+                         {
+                             std::this_thread::yield();
+                         }
+                         ++runs[i];
+                     });
+            for (auto & r : runs)
+            {
+                assert(r == 1);
+            }
+        }
+    }
+
+    std::srand(0);
+    for (std::size_t n : { std::size_t(0), std::size_t(5), std::size_t(3 * FASTCAST_BUCKET_CHUNK + 17) })
+    {
+        std::vector<A *> objects;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            objects.push_back(make(std::rand() % 6));
+        }
+
+        // the result doesn't depend on the number of workers
+        for (unsigned int workers : { 1u, 3u, 8u })
+        {
+            fastcast::work_stealing_pool pool(workers);
+            check(objects, pool);
+        }
+
+        for (auto o : objects)
+        {
+            delete o;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "fastcast.hxx"
+
+// A reserves 3 slots, B reserves 8 slots for the plugin classes
+struct A;
+struct B;
+struct C;
+struct D;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C, fastcast::slots<3>>> fcast_hierarchy;
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D, fastcast::slots<8>>> fcast_hierarchy;
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+};
+
+// The plugin classes
+template<int I>
+struct P : public A
+{
+    typedef fastcast::plugin_hierarchy<A> fcast_hierarchy;
+};
+
+template<int I>
+struct Q : public B
+{
+    typedef fastcast::plugin_hierarchy<B> fcast_hierarchy;
+};
+
+static_assert(fastcast::_is_plugin<P<0>>::value && !fastcast::_is_plugin<B>::value, "Invalid plugin test");
+static_assert(A::fcast_hierarchy::children::size == 5 && B::fcast_hierarchy::children::size == 9, "Invalid number of codes");
+
+// The plugins reserve their slots concurrently
+template<int... I>
+std::vector<unsigned int> reserve_all()
+{
+    std::vector<unsigned int> slots(sizeof...(I));
+    std::vector<std::thread> threads;
+    unsigned int (*reserve[])() = { &fastcast::plugin<Q<I>>::reserve... };
+    for (std::size_t i = 0; i < sizeof...(I); ++i)
+    {
+        threads.emplace_back([&slots, &reserve, i]() { slots[i] = reserve[i](); });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    return slots;
+}
+
+int main()
+{
+    std::vector<unsigned int> slots = reserve_all<0, 1, 2, 3, 4, 5, 6, 7>();
+    std::sort(slots.begin(), slots.end());
+    for (unsigned int i = 0; i < slots.size(); ++i)
+    {
+        assert(slots[i] == i);
+    }
+
+    bool thrown = false;
+    try
+    {
+        fastcast::plugin<Q<8>>::reserve();
+    }
+    catch (const fastcast::no_slot &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    A * p0 = fastcast::make<P<0>>();
+    A * p1 = fastcast::make<P<1>>();
+    A * q0 = fastcast::make<Q<0>>();
+    A * q7 = fastcast::make<Q<7>>();
+    A * b = fastcast::make<B>();
+    A * c = fastcast::make<C>();
+    A * d = fastcast::make<D>();
+
+    assert(Fcast::same<P<0>>(p0));
+    assert(!Fcast::instanceof<P<1>>(p0));
+    assert(!Fcast::instanceof<P<0>>(p1));
+    assert(!Fcast::instanceof<B>(p0));
+    assert(!Fcast::instanceof<C>(p0));
+    assert(Fcast::instanceof<A>(p0));
+    assert(!Fcast::instanceof<P<0>>(b));
+    assert(!Fcast::instanceof<P<0>>(c));
+    assert(!Fcast::instanceof<P<0>>(q0));
+
+    assert(Fcast::cast<Q<0>>(q0) == q0);
+    assert(Fcast::instanceof<B>(q0));
+    assert(Fcast::instanceof<A>(q7));
+    assert(!Fcast::instanceof<D>(q0));
+    assert(!Fcast::instanceof<Q<0>>(q7));
+    assert(!Fcast::instanceof<Q<0>>(d));
+    assert(!Fcast::instanceof<Q<0>>(b));
+    assert(Fcast::instanceof<B>(d));
+
+    thrown = false;
+    try
+    {
+        assert(fastcast::plugin<P<3>>::reserve() == 2);
+        fastcast::plugin<P<4>>::reserve();
+    }
+    catch (const fastcast::no_slot &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // the slot is taken on the first use of the id: its failure is thrown, not a call to std::terminate
+    static_assert(!noexcept(Fcast::instanceof<P<5>>(p0)) && noexcept(Fcast::instanceof<B>(p0)), "Only the plugin ids can throw");
+    thrown = false;
+    try
+    {
+        fastcast::make<P<5>>();
+    }
+    catch (const fastcast::no_slot &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    try
+    {
+        Fcast::instanceof<P<6>>(p0);
+    }
+    catch (const fastcast::no_slot &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // the features built on the list of the classes skip the slots and the plugin classes
+    static_assert(fastcast::dense_size<A>::value == 4, "The slots are not classes");
+    assert(fastcast::dense_index(*d) == (fastcast::dense_index_of<A, D>::value));
+    assert(fastcast::match<A>(d, [](B &) { return 1; }, [](A &) { return 2; }) == 1);
+    assert(fastcast::match<A>(c, [](B &) { return 1; }, [](A &) { return 2; }) == 2);
+    assert(fastcast::cross_cast<D>(d) == static_cast<D *>(d));
+    assert(fastcast::cross_cast<D>(c) == nullptr);
+
+    for (auto x : { p0, p1, q0, q7, b, c, d })
+    {
+        delete x;
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "fastcast_pointer.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+
+using Fcast = fastcast::fcast<A, uint8_t>;
+
+/*
+ * A--B--D
+ * |
+ * C
+ */
+
+int destroyed = 0;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    int refs;
+    A() : refs(0) { Fcast::set_id<A>(); }
+    virtual ~A() { ++destroyed; }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+void intrusive_ptr_add_ref(A * a)
+{
+    ++a->refs;
+}
+
+void intrusive_ptr_release(A * a)
+{
+    if (!--a->refs)
+    {
+        delete a;
+    }
+}
+
+// A deleter which is not a std::default_delete is kept
+struct counting_delete
+{
+    int * count;
+    void operator()(A * a) const { ++*count; delete a; }
+};
+
+// A deleter whose copy can throw
+struct throwing_delete
+{
+    throwing_delete() { }
+    throwing_delete(const throwing_delete &) { }
+    void operator()(A * a) const { delete a; }
+};
+
+static_assert(noexcept(fastcast::cast<B>(std::declval<std::unique_ptr<A>>())), "The cast of a std::unique_ptr<A> cannot throw");
+static_assert(!noexcept(fastcast::cast<B>(std::declval<std::unique_ptr<A, throwing_delete>>())), "The cast can throw when the deleter can");
+
+int main()
+{
+    // std::shared_ptr
+    {
+        std::shared_ptr<A> d = std::make_shared<D>();
+        std::shared_ptr<B> b = fastcast::cast<B>(d);
+        assert(b && b.get() == d.get() && d.use_count() == 2);
+        assert(!fastcast::cast<C>(d) && d.use_count() == 2);
+        assert(!fastcast::cast<B>(std::shared_ptr<A>()));
+
+        // the moved pointer is only taken on success
+        std::shared_ptr<C> c = fastcast::cast<C>(std::move(d));
+        assert(!c && d && d.use_count() == 2);
+        std::shared_ptr<D> dd = fastcast::cast<D>(std::move(d));
+        assert(dd && !d && dd.use_count() == 2);
+    }
+    assert(destroyed == 1);
+
+    // std::unique_ptr
+    {
+        std::unique_ptr<A> b(new B);
+        std::unique_ptr<D> d = fastcast::cast<D>(std::move(b));
+        assert(!d && b);
+        std::unique_ptr<B> bb = fastcast::cast<B>(std::move(b));
+        static_assert(std::is_same<decltype(bb), std::unique_ptr<B>>::value, "A std::unique_ptr<B> is expected");
+        assert(bb && !b);
+
+        int count = 0;
+        std::unique_ptr<A, counting_delete> c(new C, counting_delete { &count });
+        std::unique_ptr<B, counting_delete> notb = fastcast::cast<B>(std::move(c));
+        assert(!notb && c);
+        std::unique_ptr<C, counting_delete> cc = fastcast::cast<C>(std::move(c));
+        assert(cc && !c && cc.get_deleter().count == &count);
+        cc.reset();
+        assert(count == 1 && destroyed == 2);
+    }
+    assert(destroyed == 3);
+
+    // fastcast::intrusive_ptr
+    {
+        fastcast::intrusive_ptr<A> d(new D);
+        assert(d->refs == 1);
+        fastcast::intrusive_ptr<B> b = fastcast::cast<B>(d);
+        assert(b && b == d && d->refs == 2);
+        assert(!fastcast::cast<C>(d) && d->refs == 2);
+
+        fastcast::intrusive_ptr<C> c = fastcast::cast<C>(std::move(d));
+        assert(!c && d && d->refs == 2);
+        fastcast::intrusive_ptr<D> dd = fastcast::cast<D>(std::move(d));
+        assert(dd && !d && dd->refs == 2);
+
+        fastcast::intrusive_ptr<A> a = dd;
+        assert(a->refs == 3);
+        b.reset();
+        dd.reset();
+        assert(a->refs == 1 && destroyed == 3);
+    }
+    assert(destroyed == 4);
+
+    return 0;
+}
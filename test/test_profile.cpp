@@ -0,0 +1,158 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FASTCAST_PROFILE
+# define FASTCAST_PROFILE
+#endif
+
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+const fastcast::profile::record * find(const std::vector<fastcast::profile::record> & records, fastcast::profile::op kind, const std::string & target, uint64_t id)
+{
+    for (const auto & r : records)
+    {
+        if (r.where->kind == kind && r.where->target == target && r.lo == id)
+        {
+            return &r;
+        }
+    }
+
+    return nullptr;
+}
+
+void work(A * a, A * c, A * d, unsigned int n)
+{
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        assert(Fcast::cast<B>(d));
+        assert(!Fcast::cast<B>(c));
+        assert(Fcast::instanceof<A>(a));
+        assert(!Fcast::same<B>(d));
+    }
+}
+
+int main()
+{
+    using namespace fastcast::profile;
+
+    A a;
+    C c;
+    D d;
+
+    std::thread t1(work, &a, &c, &d, 1000);
+    std::thread t2(work, &a, &c, &d, 500);
+    t1.join();
+    t2.join();
+    work(&a, &c, &d, 10);
+
+    // the counters of the three threads are merged
+    const std::vector<record> records = report();
+    assert(records.size() == 4);
+    assert(dropped() == 0);
+
+    const record * r = find(records, op::cast, "B", Fcast::id<D>());
+    assert(r && r->success == 1510 && r->failure == 0);
+    assert(r->where->source == "A");
+    r = find(records, op::cast, "B", Fcast::id<C>());
+    assert(r && r->success == 0 && r->failure == 1510);
+    r = find(records, op::instanceof, "A", Fcast::id<A>());
+    assert(r && r->success == 1510 && r->failure == 0);
+    r = find(records, op::same, "B", Fcast::id<D>());
+    assert(r && r->success == 0 && r->failure == 1510);
+
+    // the reference overloads are counted as the pointer ones
+    B & b = Fcast::cast<B>(static_cast<A &>(d));
+    (void)b;
+    assert(find(report(), op::cast, "B", Fcast::id<D>())->success == 1511);
+    assert(report().front().calls() == 1511);
+
+    // the records are sorted by decreasing number of calls
+    Fcast::instanceof<C>(&c);
+    const std::vector<record> sorted = report();
+    assert(sorted.size() == 5);
+    for (std::size_t i = 1; i < sorted.size(); ++i)
+    {
+        assert(sorted[i - 1].calls() >= sorted[i].calls());
+    }
+    assert(sorted.back().calls() == 1 && sorted.back().where->target == "C");
+
+    std::ostringstream text;
+    write_text(text);
+    assert(text.str().find("cast<B>(A *)") != std::string::npos);
+    assert(text.str().find("1511 calls") != std::string::npos);
+
+    std::ostringstream json;
+    write_json(json);
+    assert(json.str().front() == '[');
+    assert(json.str().find("\"op\": \"same\"") != std::string::npos);
+    assert(json.str().find("\"source\": \"A\"") != std::string::npos);
+
+    // the names are escaped in the JSON strings
+    std::ostringstream escaped;
+    _write_json_string(escaped, "a\"b\\c\n\x01");
+    assert(escaped.str() == "\"a\\\"b\\\\c\\u000a\\u0001\"");
+
+    reset();
+    assert(report().empty());
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <unordered_set>
+
+#include "fastcast_tagged.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+
+using Fcast = fastcast::fcast<A, uint16_t>;
+
+/*
+ * A--B--D--F
+ * |  |
+ * |  E
+ * C
+ */
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    A() { Fcast::set_id<A>(); }
+    virtual ~A() { }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D, E>> fcast_hierarchy;
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<F>> fcast_hierarchy;
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    F() { Fcast::set_id<F>(); }
+};
+
+static_assert(fastcast::fits_tag<A>::value, "The ids of A fit in the tag");
+
+// Check that the tagged pointer gives the same answers as fcast
+template<typename V>
+void check(A * a)
+{
+    const fastcast::tagged_ptr<A> p(a);
+    assert(fastcast::instanceof<V>(p) == Fcast::instanceof<V>(a));
+    assert(fastcast::same<V>(p) == Fcast::same<V>(a));
+    assert(fastcast::cast<V>(p) == Fcast::cast<V>(a));
+}
+
+template<typename W>
+void check_all()
+{
+    W w;
+    A * a = &w;
+    const fastcast::tagged_ptr<A> p(a);
+    assert(p.get() == a && static_cast<A *>(p) == a && &*p == a && p.operator->() == a);
+    assert(p && p.id() == Fcast::id<W>());
+    assert(p == fastcast::make_tagged(a) && p != fastcast::tagged_ptr<A>());
+
+    check<A>(a);
+    check<B>(a);
+    check<C>(a);
+    check<D>(a);
+    check<E>(a);
+    check<F>(a);
+}
+
+int main()
+{
+    check_all<A>();
+    check_all<B>();
+    check_all<C>();
+    check_all<D>();
+    check_all<E>();
+    check_all<F>();
+
+    // a null pointer is not an instance of any class
+    const fastcast::tagged_ptr<A> null;
+    assert(!null && null == nullptr && null.get() == nullptr && null == fastcast::tagged_ptr<A>(nullptr));
+    assert(!fastcast::instanceof<A>(null) && !fastcast::instanceof<B>(null) && !fastcast::instanceof<F>(null));
+    assert(!fastcast::same<A>(null) && fastcast::cast<D>(null) == nullptr);
+
+    // the tests only use the tag: the object is not read
+    D d;
+    const fastcast::tagged_ptr<A> p(&d);
+    d._fcast_id = static_cast<uint16_t>(Fcast::id<C>());
+    assert(fastcast::instanceof<B>(p) && fastcast::same<D>(p) && !fastcast::instanceof<C>(p));
+    assert(fastcast::cast<D>(p) == &d);
+    d._fcast_id = static_cast<uint16_t>(Fcast::id<D>());
+
+    fastcast::tagged_ptr<A> q;
+    q.reset(&d);
+    assert(q == p);
+    std::unordered_set<fastcast::tagged_ptr<A>> set { p, q, null };
+    assert(set.size() == 2);
+
+    return 0;
+}
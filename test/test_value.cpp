@@ -0,0 +1,172 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fastcast_value.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+
+using Fcast = fastcast::fcast<A, uint8_t>;
+
+/*
+ * A--B--D
+ * |  |
+ * |  E
+ * C
+ */
+
+// The number of living objects (the destructors are not virtual: poly_value calls the right one)
+static int alive = 0;
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    int a;
+    A(int x = 0) : a(x) { ++alive; }
+    A(const A & o) noexcept : Fcast(o), a(o.a) { ++alive; }
+    ~A() { --alive; }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D, E>> fcast_hierarchy;
+    std::string s;
+    B(int x = 0, const std::string & y = "") : A(x), s(y) { }
+    B(const B &) = default;
+    B(B && o) noexcept : A(o), s(std::move(o.s)) { }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    double c[4];
+    C(double x = 0) : A(-1), c { x, x, x, x } { }
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    D(int x = 0) : B(x, "D") { }
+};
+
+struct E : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+    // a constructor which can throw: emplace builds the object aside
+    explicit E(bool fail) : B(5, "E") { if (fail) throw std::runtime_error("E"); }
+};
+
+using Value = fastcast::poly_value<A, 64>;
+
+int main()
+{
+    {
+        Value v;
+        assert(v.same<A>() && v->a == 0 && alive == 1);
+
+        // the ids are set by the poly_value (the constructors don't call set_id)
+        Value b = B(3, "three");
+        assert(fastcast::same<B>(b) && fastcast::instanceof<A>(b) && !fastcast::instanceof<C>(b));
+        assert(fastcast::cast<B>(b)->s == "three" && fastcast::cast<D>(b) == nullptr);
+        assert(b.id() == Fcast::id<B>());
+
+        Value d = Value::make<D>(7);
+        assert(fastcast::instanceof<B>(d) && fastcast::same<D>(d) && d->a == 7 && d.cast<B>()->s == "D");
+
+        // copy and move through the table of operations
+        Value copy(d);
+        assert(fastcast::same<D>(copy) && copy.cast<D>()->s == "D" && copy.cast<D>() != d.cast<D>());
+        Value moved(std::move(b));
+        assert(fastcast::same<B>(moved) && moved.cast<B>()->s == "three" && b.cast<B>()->s.empty());
+        v = copy;
+        assert(fastcast::same<D>(v) && v.cast<D>()->s == "D");
+        v = std::move(moved);
+        assert(fastcast::same<B>(v) && v.cast<B>()->s == "three");
+        Value & self = v;
+        v = self;
+        assert(fastcast::same<B>(v) && v.cast<B>()->s == "three");
+
+        C & c = v.emplace<C>(2.5);
+        assert(&c == v.cast<C>() && fastcast::same<C>(v) && c.c[3] == 2.5);
+
+        // the object is not changed when the constructor throws
+        bool thrown = false;
+        try
+        {
+            v.emplace<E>(true);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown && fastcast::same<C>(v));
+        v.emplace<E>(false);
+        assert(fastcast::same<E>(v) && v.cast<B>()->s == "E");
+
+        const Value & cv = v;
+        assert(fastcast::cast<B>(cv)->a == 5 && cv.cast<C>() == nullptr);
+
+        // a type switch
+        auto kind = [](Value & x) { return fastcast::visit(x, [](D &) { return 1; }, [](B &) { return 2; }, [](A &) { return 3; }); };
+        assert(kind(d) == 1 && kind(v) == 2 && kind(copy) == 1);
+        Value a(A(4));
+        assert(kind(a) == 3);
+
+        // the values are contiguous in a vector
+        std::vector<Value> values;
+        for (int i = 0; i < 100; ++i)
+        {
+            switch (i % 4)
+            {
+            case 0: values.emplace_back(A(i)); break;
+            case 1: values.emplace_back(B(i, "b")); break;
+            case 2: values.emplace_back(C(i)); break;
+            default: values.push_back(Value::make<D>(i)); break;
+            }
+        }
+        std::vector<Value> other(values);
+        for (int i = 0; i < 100; ++i)
+        {
+            assert(values[i].same<A>() == (i % 4 == 0) && values[i].same<B>() == (i % 4 == 1));
+            assert(values[i].same<C>() == (i % 4 == 2) && values[i].same<D>() == (i % 4 == 3));
+            assert(other[i].id() == values[i].id() && (i % 4 == 2 || other[i]->a == i));
+            assert(other[i].instanceof<B>() == (i % 4 == 1 || i % 4 == 3));
+        }
+        assert(reinterpret_cast<char *>(&values[1]) - reinterpret_cast<char *>(&values[0]) == sizeof(Value));
+    }
+
+    // each object has been destroyed by the destructor of its class
+    assert(alive == 0);
+
+    return 0;
+}
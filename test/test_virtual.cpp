@@ -0,0 +1,218 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+using FcastA = fastcast::fcast<A, uint8_t>;
+using FcastD = fastcast::fcast<D, uint8_t>;
+
+/*
+ *        Base
+ *       /    \      (virtual)
+ *      A      D
+ *     / \    / \    (virtual)
+ *    C   B  E   F
+ *         \/
+ *         G
+ *         |
+ *         H
+ */
+
+struct Base
+{
+    int base;
+    Base() : base(0) { }
+    virtual ~Base() { }
+};
+
+struct A : public virtual Base, public FcastA
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+    int a;
+    A() : a(1) { FcastA::set_id<A>(); }
+};
+
+struct B : public virtual A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G>> fcast_hierarchy;
+    int b;
+    B() : b(2) { FcastA::set_id<B>(); }
+};
+
+struct C : public virtual A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+    int c;
+    C() : c(3) { FcastA::set_id<C>(); }
+};
+
+struct D : public virtual Base, public FcastD
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<E, F>> fcast_hierarchy;
+    int d;
+    D() : d(4) { FcastD::set_id<D>(); }
+};
+
+struct E : public virtual D
+{
+    typedef fastcast::hierarchy<D, fastcast::children<G>> fcast_hierarchy;
+    int e;
+    E() : e(5) { FcastD::set_id<E>(); }
+};
+
+struct F : public D
+{
+    typedef fastcast::hierarchy<D> fcast_hierarchy;
+    int f;
+    F() : f(6) { FcastD::set_id<F>(); }
+};
+
+struct G : public B, public E
+{
+    typedef fastcast::hierarchy<fastcast::parents<B, E>, fastcast::children<H>> fcast_hierarchy;
+    int g;
+    G() : g(7)
+        {
+            FcastA::set_id<G>();
+            FcastD::set_id<G>();
+        }
+};
+
+struct H : public G
+{
+    typedef fastcast::hierarchy<G> fcast_hierarchy;
+    int h;
+    H() : h(8)
+        {
+            FcastA::set_id<H>();
+            FcastD::set_id<H>();
+        }
+};
+
+// fastcast::cross_cast gives the same pointer as dynamic_cast
+template<typename To, typename W>
+void check(W * w)
+{
+    assert(fastcast::cross_cast<To>(w) == dynamic_cast<To *>(w));
+}
+
+template<typename W>
+void check_all(W * w)
+{
+    check<A>(w);
+    check<B>(w);
+    check<C>(w);
+    check<D>(w);
+    check<E>(w);
+    check<F>(w);
+    check<G>(w);
+    check<H>(w);
+}
+
+int main()
+{
+    B b;
+    C c;
+    F f;
+    G g1, g2;
+    H h;
+
+    // downcasts from a virtual base
+    A * a = &b;
+    assert(FcastA::cast<B>(a) == &b && FcastA::cast<B>(a)->b == 2);
+    assert(!FcastA::cast<C>(a) && !FcastA::cast<G>(a));
+    a = &g1;
+    assert(FcastA::cast<G>(a) == &g1 && FcastA::cast<G>(a)->g == 7);
+    assert(FcastA::cast<B>(a) == static_cast<B *>(&g1));
+    assert(!FcastA::cast<H>(a));
+    a = &h;
+    assert(FcastA::cast<G>(a) == &h && FcastA::cast<H>(a)->h == 8);
+    D * d = &h;
+    assert(FcastD::cast<E>(d) == static_cast<E *>(&h) && FcastD::cast<H>(d) == &h);
+    assert(&FcastA::cast<G>(static_cast<A &>(g2)) == &g2);
+    assert(&FcastA::cast_unchecked<G>(static_cast<A &>(g2)) == &g2);
+
+    bool thrown = false;
+    try
+    {
+        FcastA::cast<G>(static_cast<A &>(c));
+    }
+    catch (const fastcast::bad_cast &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // the offsets are computed with the first object of each class and they are valid for the others
+    assert(fastcast::cross_cast<E>(static_cast<A *>(&g1)) == static_cast<E *>(&g1));
+    assert(fastcast::cross_cast<E>(static_cast<A *>(&g2)) == static_cast<E *>(&g2));
+    assert(fastcast::cross_cast<E>(static_cast<A *>(&g2))->e == 5);
+    assert(fastcast::cross_cast<A>(static_cast<D *>(&h))->a == 1);
+
+    check_all(static_cast<A *>(&b));
+    check_all(static_cast<A *>(&c));
+    check_all(static_cast<D *>(&f));
+    check_all(static_cast<A *>(&g1));
+    check_all(static_cast<D *>(&g2));
+    check_all(static_cast<A *>(&h));
+    check_all(static_cast<D *>(&h));
+    check_all(static_cast<B *>(&h));
+    check_all(static_cast<E *>(&g1));
+
+    // the lazy offsets can be computed by several threads at the same time
+    std::vector<std::thread> threads;
+    std::vector<H> hs(64);
+    for (unsigned int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&hs]()
+            {
+                for (auto & x : hs)
+                {
+                    assert(fastcast::cross_cast<F>(static_cast<D *>(&x)) == nullptr);
+                    assert(fastcast::cross_cast<C>(static_cast<B *>(&x)) == nullptr);
+                    assert(FcastD::cast<G>(static_cast<D *>(&x)) == &x);
+                }
+            });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    return 0;
+}
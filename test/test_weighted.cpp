@@ -0,0 +1,177 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+
+#include "fastcast.hxx"
+
+struct A;
+struct B;
+struct C;
+struct D;
+struct E;
+struct F;
+struct G;
+struct H;
+
+template<int N>
+struct K;
+
+using Fcast = fastcast::fcast<A, uint32_t>;
+
+/*
+  A->B(95),C,D,E,F
+  B->G,H
+  C->K<1>(1),K<2>(2),K<3>(3),K<4>(5),...,K<9>(55)
+  G->K<10>
+*/
+
+struct A : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<fastcast::weight<B, 95>, C, D, E, F>> fcast_hierarchy;
+
+    A() { Fcast::set_id<A>(); }
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<G, H>> fcast_hierarchy;
+
+    B() { Fcast::set_id<B>(); }
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<fastcast::weight<K<1>, 1>, fastcast::weight<K<2>, 2>, fastcast::weight<K<3>, 3>,
+                                                      fastcast::weight<K<4>, 5>, fastcast::weight<K<5>, 8>, fastcast::weight<K<6>, 13>,
+                                                      fastcast::weight<K<7>, 21>, fastcast::weight<K<8>, 34>, fastcast::weight<K<9>, 55>>> fcast_hierarchy;
+
+    C() { Fcast::set_id<C>(); }
+};
+
+struct D : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    D() { Fcast::set_id<D>(); }
+};
+
+struct E : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    E() { Fcast::set_id<E>(); }
+};
+
+struct F : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+
+    F() { Fcast::set_id<F>(); }
+};
+
+struct G : public B
+{
+    typedef fastcast::hierarchy<B, fastcast::children<K<10>>> fcast_hierarchy;
+
+    G() { Fcast::set_id<G>(); }
+};
+
+struct H : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+
+    H() { Fcast::set_id<H>(); }
+};
+
+template<int N>
+struct Parent
+{
+    typedef C type;
+};
+
+template<>
+struct Parent<10>
+{
+    typedef G type;
+};
+
+template<int N>
+struct K : public Parent<N>::type
+{
+    typedef fastcast::hierarchy<typename Parent<N>::type> fcast_hierarchy;
+
+    K() { Fcast::set_id<K>(); }
+};
+
+// Check instanceof and same for an instance of X against all the classes
+template<typename X, typename... V>
+void check_one(fastcast::type_list<V...>)
+{
+    X x;
+    A * a = &x;
+    const bool instanceof[] = { Fcast::instanceof<V>(a)... };
+    const bool derived[] = { std::is_base_of<V, X>::value... };
+    const bool same[] = { Fcast::same<V>(a)... };
+    const bool is_same[] = { std::is_same<V, X>::value... };
+
+    for (std::size_t i = 0; i < sizeof...(V); ++i)
+    {
+        assert(instanceof[i] == derived[i]);
+        assert(same[i] == is_same[i]);
+    }
+}
+
+template<typename... X>
+void check_all(fastcast::type_list<X...> l)
+{
+    const int dummy[] = { (check_one<X>(l), 0)... };
+    (void)dummy;
+}
+
+constexpr unsigned int bits(fastcast::fcast_id_t id)
+{
+    return fastcast::number_of_bits(id);
+}
+
+int main()
+{
+    // B is coded with 1 bit (plus the delimiter) instead of 3 (plus the delimiter)
+    static_assert(bits(Fcast::id<B>()) == 3, "Bad length");
+    static_assert(bits(Fcast::id<C>()) == 5, "Bad length");
+    static_assert(bits(Fcast::id<F>()) == 5, "Bad length");
+
+    // the most frequent child of C has the shortest code
+    static_assert(bits(Fcast::id<K<9>>()) == bits(Fcast::id<C>()) + 2, "Bad length");
+    static_assert(bits(Fcast::id<K<1>>()) == bits(Fcast::id<C>()) + 9, "Bad length");
+
+    // the unweighted children keep the same codes
+    static_assert(Fcast::id<G>() == ((0b10 << bits(Fcast::id<B>())) | Fcast::id<B>()), "Bad id");
+    static_assert(Fcast::id<H>() == ((0b11 << bits(Fcast::id<B>())) | Fcast::id<B>()), "Bad id");
+
+    check_all(fastcast::hierarchy_of<A>::type());
+
+    return 0;
+}
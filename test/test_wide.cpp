@@ -0,0 +1,192 @@
+// Copyright (c) 2014, Calixte DENIZET
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the <organization> nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+
+#include "fastcast.hxx"
+
+// A chain of Depth classes K<0>, ..., K<Depth - 1> where each K<N> also has two leaves L<N + 1> and M<N + 1>:
+// each level costs 3 bits, so the ids of the deepest classes need more than 64 bits.
+
+constexpr int Depth = 24;
+
+template<int N>
+struct K;
+
+template<int N>
+struct L;
+
+template<int N>
+struct M;
+
+using Fcast = fastcast::fcast<K<0>, unsigned __int128>;
+
+template<int N>
+struct Children
+{
+    typedef fastcast::children<K<N>, L<N>, M<N>> type;
+};
+
+template<>
+struct Children<Depth>
+{
+    typedef void type;
+};
+
+template<>
+struct K<0> : public Fcast
+{
+    typedef fastcast::hierarchy<fastcast::root, Children<1>::type> fcast_hierarchy;
+
+    K() { Fcast::set_id<K>(); }
+};
+
+template<int N>
+struct K : public K<N - 1>
+{
+    typedef fastcast::hierarchy<K<N - 1>, typename Children<N + 1>::type> fcast_hierarchy;
+
+    K() { Fcast::set_id<K>(); }
+};
+
+template<int N>
+struct L : public K<N - 1>
+{
+    typedef fastcast::hierarchy<K<N - 1>> fcast_hierarchy;
+
+    L() { Fcast::set_id<L>(); }
+};
+
+template<int N>
+struct M : public K<N - 1>
+{
+    typedef fastcast::hierarchy<K<N - 1>> fcast_hierarchy;
+
+    M() { Fcast::set_id<M>(); }
+};
+
+// A small hierarchy (the one of test.cpp)
+struct A;
+struct B;
+struct C;
+struct D;
+
+using FcastA = fastcast::fcast<A, uint8_t>;
+
+struct A : public FcastA
+{
+    typedef fastcast::hierarchy<fastcast::root, fastcast::children<B, C>> fcast_hierarchy;
+};
+
+struct B : public A
+{
+    typedef fastcast::hierarchy<A, fastcast::children<D>> fcast_hierarchy;
+};
+
+struct C : public A
+{
+    typedef fastcast::hierarchy<A> fcast_hierarchy;
+};
+
+struct D : public B
+{
+    typedef fastcast::hierarchy<B> fcast_hierarchy;
+};
+
+// L<J> and M<J> are instances of K<I> iff I < J
+template<int I, int J>
+struct CheckLeaves
+{
+    static void run()
+        {
+            L<J> l;
+            M<J> m;
+            assert(Fcast::instanceof<K<I>>(static_cast<K<0> *>(&l)) == (I < J));
+            assert(Fcast::instanceof<K<I>>(static_cast<K<0> *>(&m)) == (I < J));
+            assert(Fcast::instanceof<L<J>>(static_cast<K<0> *>(&l)));
+            assert(!Fcast::instanceof<L<J>>(static_cast<K<0> *>(&m)));
+            assert(!Fcast::instanceof<M<J>>(static_cast<K<0> *>(&l)));
+        }
+};
+
+template<int I>
+struct CheckLeaves<I, 0>
+{
+    static void run() { }
+};
+
+// K<J> is an instance of K<I> iff I <= J
+template<int I, int J>
+struct Check
+{
+    static void run()
+        {
+            K<J> k;
+            K<0> * p = &k;
+            assert(Fcast::instanceof<K<I>>(p) == (I <= J));
+            assert(Fcast::same<K<I>>(p) == (I == J));
+            CheckLeaves<I, J>::run();
+            Check<I, J + 1>::run();
+        }
+};
+
+template<int I>
+struct Check<I, Depth>
+{
+    static void run() { }
+};
+
+template<int I>
+struct CheckAll
+{
+    static void run()
+        {
+            Check<I, 0>::run();
+            CheckAll<I + 1>::run();
+        }
+};
+
+template<>
+struct CheckAll<Depth>
+{
+    static void run() { }
+};
+
+int main()
+{
+    // 1 bit for the root and 3 bits per level
+    static_assert(fastcast::id_bits<K<0>>::value == 1 + 3 * (Depth - 1), "Bad number of bits");
+    static_assert(fastcast::id_bits<K<0>>::value > 64, "The ids must be longer than 64 bits");
+    static_assert(std::is_same<fastcast::id_type<K<0>>::type, unsigned __int128>::value, "Bad id type");
+    static_assert(std::is_same<fastcast::fcast_id_t, uint64_t>::value, "The default id type stays 64 bits wide");
+
+    static_assert(fastcast::id_bits<A>::value == 4, "Bad number of bits");
+    static_assert(std::is_same<fastcast::id_type<A>::type, uint8_t>::value, "Bad id type");
+    static_assert(std::is_same<fastcast::uint_least<17>::type, uint32_t>::value, "Bad id type");
+
+    CheckAll<0>::run();
+
+    return 0;
+}